@@ -4,10 +4,18 @@
 #include "boost/program_options.hpp"
 #include "boost/filesystem.hpp"
 #include "../utils/OptionPrinter.hpp"
+#include "../utils/PayloadGenerator.hpp"
+#include "../utils/TraceRecorder.hpp"
+#include "../utils/LatencyHistogram.hpp"
+#include "../utils/BenchmarkRecord.hpp"
+#include "../utils/PerfCounters.hpp"
+#include "../utils/BusyPollLoop.hpp"
 #include "boost/lexical_cast.hpp"
 #include "boost/asio/deadline_timer.hpp"
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <iostream>
 #include <fstream>
@@ -16,6 +24,21 @@ using namespace boost::program_options;
 
 namespace ndn {
 
+/** Result of one rate step of the capacity search */
+struct SearchStep
+{
+  int rate;
+  unsigned int sent;
+  unsigned int satisfied;
+  LatencyHistogram rtt;
+  bool passed;
+
+  double getLoss() const
+  {
+    return sent > 0 ? 1.0 - ((double) satisfied) / (double) sent : 1.0;
+  }
+};
+
 class Consumer : noncopyable
 {
 public:
@@ -34,6 +57,19 @@ public:
     this-> rtx_counter = 0;
     this->debug = false;
     this->rtx = false;
+    this->verify = false;
+    this->verify_size = 0;
+    this->payload_mismatches = 0;
+
+    this->search = false;
+    this->measuring = false;
+    this->best_rate = 0;
+    this->failed_rate = 0;
+    this->last_received = 0;
+    this->last_rtt = 0;
+    this->jitter_sum = 0;
+    this->jitter_samples = 0;
+    this->stage_encode = this->stage_express = this->stage_data = 0;
   }
 
   void run()
@@ -41,10 +77,33 @@ public:
     boost::asio::deadline_timer timer(m_ioService, boost::posix_time::microseconds(1000000/rate));
     timer.async_wait(bind(&Consumer::expressInterest, this, &timer));
 
-    boost::asio::deadline_timer stopTimer(m_ioService, boost::posix_time::seconds(run_time));
-    stopTimer.async_wait(bind(&Consumer::stopConsumer, this));
+    // in search mode run_time is the hold time of each step, the search decides when to stop
+    boost::asio::deadline_timer stopTimer(m_ioService);
+    if(search)
+      startStep(search_min);
+    else
+    {
+      stopTimer.expires_from_now(boost::posix_time::seconds(run_time));
+      stopTimer.async_wait(bind(&Consumer::stopConsumer, this));
+      // a search mixes warm-ups and several rates, so throughput is only sampled for fixed-rate runs
+      m_scheduler.scheduleEvent(time::seconds(1), bind(&Consumer::sampleThroughput, this));
+    }
 
-    m_face.processEvents();
+    if(!cpus.empty())
+      pinCurrentThread(cpus[0]);
+
+    if(busy_poll)
+      busy_poll->run();
+    else
+      m_face.processEvents();
+
+    if(tracer)
+    {
+      uint64_t dropped = tracer->getDropped();
+      tracer.reset(); // drains the rings and closes the trace file
+      if(dropped > 0)
+        std::cerr << "WARNING: Dropped " << dropped << " trace events" << std::endl;
+    }
 
     std::cout << "Distinguished Interests Send: " << interest_send << std::endl;
     if(rtx)
@@ -56,6 +115,56 @@ public:
 
     double ratio = ((double) data_received) / (double) (interest_send + rtx_counter);
     std::cout << "Total Interset/Data ratio: " << ratio << std::endl;
+    std::cout << "Round Trip Time (usec): mean " << rtt.getMean()
+              << ", p50 " << rtt.getPercentile(50)
+              << ", p90 " << rtt.getPercentile(90)
+              << ", p99 " << rtt.getPercentile(99)
+              << ", max " << rtt.getMax() << std::endl;
+    std::cout << "Round Trip Time Jitter (usec): stddev " << rtt.getStddev()
+              << ", mean consecutive difference " << getJitter() << std::endl;
+
+    if(verify)
+      std::cout << "Payload Mismatches: " << payload_mismatches << std::endl;
+
+    if(search)
+      printSearchResult();
+
+    if(perf)
+      perf->printReport(std::cout);
+
+    if(busy_poll)
+      busy_poll->printReport(std::cout);
+  }
+
+  /** Adds the results of the finished run to record */
+  void addMetrics(BenchmarkRecord& record)
+  {
+    // errors are standard errors within this run, run to run noise needs several records
+    if(!search)
+    {
+      double throughput, throughput_stddev;
+      BenchmarkRecord::computeStats(throughput_samples, throughput, throughput_stddev);
+      double throughput_noise = throughput_samples.empty() ? 0 : throughput_stddev / std::sqrt((double) throughput_samples.size());
+      record.addMetric("throughput", throughput, true, "Data/s", throughput_noise);
+    }
+
+    unsigned int sent = interest_send + rtx_counter;
+    record.addMetric("satisfaction_ratio", sent > 0 ? ((double) data_received) / (double) sent : 0, true, "ratio");
+
+    double rtt_noise = rtt.getCount() > 0 ? rtt.getStddev() / std::sqrt((double) rtt.getCount()) : 0;
+    record.addMetric("rtt_mean", rtt.getMean(), false, "usec", rtt_noise);
+    record.addMetric("rtt_p50", rtt.getPercentile(50), false, "usec");
+    record.addMetric("rtt_p90", rtt.getPercentile(90), false, "usec");
+    record.addMetric("rtt_p99", rtt.getPercentile(99), false, "usec");
+    record.addMetric("rtt_max", rtt.getMax(), false, "usec");
+    record.addMetric("rtt_stddev", rtt.getStddev(), false, "usec");
+    record.addMetric("rtt_jitter", getJitter(), false, "usec");
+
+    if(verify)
+      record.addMetric("payload_mismatches", payload_mismatches, false, "packets");
+
+    if(search)
+      record.addMetric("max_sustainable_rate", best_rate, true, "Interests/s");
   }
 
   void setDebug(bool debug)
@@ -68,6 +177,58 @@ public:
     this->rtx = rtx;
   }
 
+  /** Checks payloads against the deterministic stream, expected_size is the producer's --data-size */
+  void setVerify(size_t expected_size)
+  {
+    this->verify = true;
+    this->verify_size = expected_size;
+  }
+
+  void setTrace(const std::string& fname)
+  {
+    tracer = make_shared<TraceRecorder>(fname);
+  }
+
+  /** Spins up to spin_budget usec (-1 forever) on the io_service before sleeping */
+  void setBusyPoll(int spin_budget)
+  {
+    busy_poll = make_shared<BusyPollLoop>(m_ioService, spin_budget);
+  }
+
+  /** The Face thread is pinned to the first CPU */
+  void setCpus(const std::vector<int>& cpus)
+  {
+    this->cpus = cpus;
+  }
+
+  /** Counts on the calling thread, so call it from the thread that runs run() */
+  void setPerfCounters()
+  {
+    perf = make_shared<PerfCounters>();
+    if(!perf->open())
+      std::cerr << "WARNING: Performance counters unavailable: " << perf->getError() << std::endl;
+
+    stage_encode = perf->addStage("encode");
+    stage_express = perf->addStage("express");
+    stage_data = perf->addStage("data");
+  }
+
+  /**
+   * Enables the capacity search between min_rate and the configured rate.
+   * A step of 0 selects a binary search with a resolution of 1% of the configured rate.
+   */
+  void setCapacitySearch(int min_rate, int step, int warmup, double max_loss, double max_p99)
+  {
+    this->search = true;
+    this->search_min = std::max(1, min_rate);
+    this->search_max = rate;
+    this->search_linear = step > 0;
+    this->search_step = step > 0 ? step : std::max(1, rate / 100);
+    this->warmup = warmup;
+    this->max_loss = max_loss;
+    this->max_p99 = max_p99;
+  }
+
 private:
 
   void expressInterest(boost::asio::deadline_timer* timer)
@@ -81,16 +242,32 @@ private:
     }
     else // new interest
     {
-      Interest interest(Name(prefix + "/" + boost::lexical_cast<std::string>(counter++)));
-      interest.setInterestLifetime(time::milliseconds(lifetime));
-      interest.setMustBeFresh(true);
-
-      m_face.expressInterest(interest,
-                             bind(&Consumer::onData, this,  _1, _2),
-                             bind(&Consumer::onTimeout, this, _1));
+      Interest interest;
+      {
+        // encoding here keeps it out of expressInterest, the Face reuses the cached wire
+        PerfScope scope(perf.get(), stage_encode);
+        interest.setName(Name(prefix + "/" + boost::lexical_cast<std::string>(counter++)));
+        interest.setInterestLifetime(time::milliseconds(lifetime));
+        interest.setMustBeFresh(true);
+        interest.wireEncode();
+      }
+
+      // only Interests sent inside the measurement window of a search step are accounted to it
+      int step = measuring ? (int) steps.size() - 1 : -1;
+      if(step >= 0)
+        steps.back().sent++;
+
+      {
+        PerfScope scope(perf.get(), stage_express);
+        m_face.expressInterest(interest,
+                               bind(&Consumer::onData, this,  _1, _2, time::steady_clock::now(), step),
+                               bind(&Consumer::onTimeout, this, _1));
+      }
 
       if(debug)
         std::cout << "Sending: " << interest << std::endl;
+      if(tracer)
+        tracer->record(TRACE_INTEREST_SENT, nameHash(interest.getName()), interest.wireEncode().size());
       this->interest_send++;
     }
 
@@ -98,17 +275,51 @@ private:
     timer->async_wait(bind(&Consumer::expressInterest, this, timer));
   }
 
-  void onData(const Interest& interest, const Data& data)
+  void onData(const Interest& interest, const Data& data, time::steady_clock::TimePoint sent, int step)
   {
+    PerfScope scope(perf.get(), stage_data);
+
+    uint64_t usec = time::duration_cast<time::microseconds>(time::steady_clock::now() - sent).count();
+    rtt.add(usec);
+    if(rtt.getCount() > 1)
+    {
+      jitter_sum += usec > last_rtt ? usec - last_rtt : last_rtt - usec;
+      jitter_samples++;
+    }
+    last_rtt = usec;
+    if(step >= 0)
+    {
+      steps[step].satisfied++;
+      steps[step].rtt.add(usec);
+    }
+
     if(debug)
       std::cout << "Received: " << data << std::endl;
+    if(tracer)
+      tracer->record(TRACE_DATA_RECEIVED, nameHash(interest.getName()), data.wireEncode().size());
     this->data_received++;
+
+    if(verify)
+    {
+      // the producer derives the payload from the name of the Interest it answers,
+      // empty or truncated content counts as a mismatch as well
+      const Block& content = data.getContent();
+      if(content.value_size() != verify_size ||
+         !PayloadGenerator::verify(nameHash(interest.getName()), content.value(), content.value_size()))
+      {
+        if(debug)
+          std::cout << "Payload mismatch: " << data.getName() << std::endl;
+        this->payload_mismatches++;
+      }
+    }
   }
 
   void onTimeout(const Interest& interest)
   {
     if(debug)
       std::cout << "Timeout " << interest << std::endl;
+    if(tracer)
+      tracer->record(TRACE_TIMEOUT, nameHash(interest.getName()), interest.wireEncode().size());
 
     if(rtx)
       rtx_queue.push_back (interest.getName ().toUri ());
@@ -124,11 +335,13 @@ private:
     rtx_interest.setMustBeFresh(true);
 
     m_face.expressInterest(rtx_interest,
-                           bind(&Consumer::onData, this,  _1, _2),
+                           bind(&Consumer::onData, this,  _1, _2, time::steady_clock::now(), -1),
                            bind(&Consumer::onTimeout, this, _1));
 
     if(debug)
       std::cout << "Rtx: " << rtx_interest << std::endl;
+    if(tracer)
+      tracer->record(TRACE_RETRANSMISSION, nameHash(rtx_interest.getName()), rtx_interest.wireEncode().size());
 
     rtx_counter++;
   }
@@ -138,6 +351,134 @@ private:
     this->stop_consumer = true;
   }
 
+  /** Mean absolute difference of consecutive RTTs */
+  double getJitter() const
+  {
+    return jitter_samples > 0 ? jitter_sum / jitter_samples : 0;
+  }
+
+  void sampleThroughput()
+  {
+    if(stop_consumer)
+      return;
+
+    throughput_samples.push_back(data_received - last_received);
+    last_received = data_received;
+    m_scheduler.scheduleEvent(time::seconds(1), bind(&Consumer::sampleThroughput, this));
+  }
+
+  void startStep(int step_rate)
+  {
+    // the Interest timer picks up the new rate with its next expiry
+    this->rate = step_rate;
+    steps.push_back(SearchStep());
+    steps.back().rate = step_rate;
+    steps.back().sent = 0;
+    steps.back().satisfied = 0;
+    steps.back().passed = false;
+
+    m_scheduler.scheduleEvent(time::seconds(warmup), bind(&Consumer::startMeasurement, this));
+  }
+
+  void startMeasurement()
+  {
+    measuring = true;
+    m_scheduler.scheduleEvent(time::seconds(run_time), bind(&Consumer::stopMeasurement, this));
+  }
+
+  void stopMeasurement()
+  {
+    // keep offering load while the Interests of the window are answered or expire
+    measuring = false;
+    m_scheduler.scheduleEvent(time::milliseconds(lifetime), bind(&Consumer::evaluateStep, this));
+  }
+
+  void evaluateStep()
+  {
+    SearchStep& step = steps.back();
+    double p99 = step.rtt.getPercentile(99) / 1000.0;
+    step.passed = step.sent > 0 && step.getLoss() <= max_loss && p99 <= max_p99;
+
+    std::cout << "Search Step: rate " << step.rate
+              << ", loss " << step.getLoss()
+              << ", p99 " << p99 << "msec"
+              << (step.passed ? " (passed)" : " (failed)") << std::endl;
+
+    if(step.passed)
+      best_rate = std::max(best_rate, step.rate);
+
+    int next = nextSearchRate(step);
+    if(next > 0)
+      startStep(next);
+    else
+      stopConsumer();
+  }
+
+  /** Returns the rate of the next step, or 0 if the search is finished */
+  int nextSearchRate(const SearchStep& step)
+  {
+    if(search_linear)
+    {
+      if(!step.passed || step.rate >= search_max)
+        return 0;
+      return std::min(step.rate + search_step, search_max);
+    }
+
+    // binary search: best_rate is the highest passed rate, failed_rate the lowest failed one
+    if(!step.passed)
+    {
+      if(steps.size() == 1)
+        return 0; // even the minimum rate violates the SLO
+      failed_rate = step.rate;
+    }
+    else if(steps.size() == 1)
+    {
+      failed_rate = search_max + 1;
+      return search_max > step.rate ? search_max : 0;
+    }
+
+    if(failed_rate - best_rate <= search_step)
+      return 0;
+    return best_rate + (failed_rate - best_rate) / 2;
+  }
+
+  void printSearchResult()
+  {
+    std::vector<SearchStep> curve(steps);
+    std::sort(curve.begin(), curve.end(), compareStepRate);
+
+    std::cout << "Latency Curve:" << std::endl;
+    std::cout << "rate,sent,satisfied,loss,mean_usec,p50_usec,p90_usec,p99_usec,slo" << std::endl;
+    for(std::vector<SearchStep>::iterator it = curve.begin(); it != curve.end(); ++it)
+    {
+      std::cout << it->rate << ","
+                << it->sent << ","
+                << it->satisfied << ","
+                << it->getLoss() << ","
+                << it->rtt.getMean() << ","
+                << it->rtt.getPercentile(50) << ","
+                << it->rtt.getPercentile(90) << ","
+                << it->rtt.getPercentile(99) << ","
+                << (it->passed ? "passed" : "failed") << std::endl;
+    }
+
+    if(best_rate > 0)
+      std::cout << "Max Sustainable Rate: " << best_rate << " Interests/s" << std::endl;
+    else
+      std::cout << "Max Sustainable Rate: None (minimum rate violates the SLO)" << std::endl;
+  }
+
+  static bool compareStepRate(const SearchStep& a, const SearchStep& b)
+  {
+    return a.rate < b.rate;
+  }
+
+  uint64_t nameHash(const Name& name)
+  {
+    const Block& wire = name.wireEncode();
+    return PayloadGenerator::hash(wire.wire(), wire.size());
+  }
+
 private:
   boost::asio::io_service m_ioService;
   Face m_face;
@@ -150,12 +491,41 @@ private:
   bool stop_consumer;
   bool debug;
   bool rtx;
+  bool verify;
+  size_t verify_size;
 
   unsigned int interest_send;
   unsigned int data_received;
   unsigned int rtx_counter;
+  unsigned int payload_mismatches;
 
   std::vector<std::string> rtx_queue;
+  shared_ptr<TraceRecorder> tracer;
+  LatencyHistogram rtt;
+  uint64_t last_rtt;
+  double jitter_sum;
+  uint64_t jitter_samples;
+  std::vector<double> throughput_samples; // Data received per second
+  unsigned int last_received;
+  shared_ptr<PerfCounters> perf;
+  size_t stage_encode;
+  size_t stage_express;
+  size_t stage_data;
+  shared_ptr<BusyPollLoop> busy_poll;
+  std::vector<int> cpus;
+
+  bool search;
+  bool search_linear;
+  bool measuring;
+  int search_min;
+  int search_max;
+  int search_step;
+  int warmup;
+  double max_loss;
+  double max_p99;
+  int best_rate;
+  int failed_rate;
+  std::vector<SearchStep> steps;
 };
 
 }
@@ -173,9 +543,21 @@ main(int argc, char** argv)
       ("rate,r", value<int>()->required (), "Interests per second issued. (Required)")
       ("run-time,t", value<int>()->required (), "Runtime of Producer in Seconds. (Required)")
       ("rtx,x", "Enable Retransmissions. (Optional)")
+      ("search,S", "Searches the maximum rate up to --rate that meets the SLO, --run-time is the hold time per step. (Optional)")
+      ("search-min", value<int>(), "Lowest rate of the capacity search. (Default 10% of --rate)")
+      ("search-step", value<int>(), "Rate increment of a linear capacity search. (Default binary search)")
+      ("warmup,w", value<int>(), "Discarded warm-up time per search step in seconds. (Default 2sec)")
+      ("max-loss", value<double>(), "SLO: maximum loss ratio per search step. (Default 0.01)")
+      ("max-p99", value<double>(), "SLO: maximum 99th percentile RTT per search step in msec. (Default 100msec)")
       ("lifetime,l", value<int>(), "Interest Lifetime (Default 1000msec)")
+      ("verify,c", value<int>(), "Verifies the payload of producers running with --deterministic and --data-size SIZE. (Optional)")
+      ("perf-counters,P", "Reports hardware performance counters per packet for encode, express and data at exit. (Optional)")
+      ("busy-poll,B", value<int>(), "Polls the Face for USEC after the last event before sleeping, -1 never sleeps. (Optional)")
+      ("cpus,C", value<std::string>(), "Pins the Face thread to the first CPU of the list (e.g. 2,4-6). (Optional)")
       ("debug,v", "Enables Debug. (Optional)")
-      ("logfile,o", value<std::string>(), "Writes Output to LogFile. (Optional)");
+      ("logfile,o", value<std::string>(), "Writes Output to LogFile. (Optional)")
+      ("trace,T", value<std::string>(), "Writes a binary event trace to this file, decode it with trace-decoder. (Optional)")
+      ("results-dir,R", value<std::string>(), "Stores a benchmark record of the run in this directory, compare records with compare-results. (Optional)");
 
   positional_options_description positionalOptions;
   variables_map vm;
@@ -254,9 +636,42 @@ main(int argc, char** argv)
   else
     consumer.setRtx(false);
 
+  if(vm.count("verify"))
+    consumer.setVerify(std::max(0, vm["verify"].as<int>()));
+
+  if(vm.count("busy-poll"))
+    consumer.setBusyPoll(vm["busy-poll"].as<int>());
+
+  if(vm.count("perf-counters"))
+    consumer.setPerfCounters();
+
+  if(vm.count("search"))
+  {
+    int rate = vm["rate"].as<int>();
+    consumer.setCapacitySearch(vm.count("search-min") ? vm["search-min"].as<int>() : rate / 10,
+                               vm.count("search-step") ? vm["search-step"].as<int>() : 0,
+                               vm.count("warmup") ? vm["warmup"].as<int>() : 2,
+                               vm.count("max-loss") ? vm["max-loss"].as<double>() : 0.01,
+                               vm.count("max-p99") ? vm["max-p99"].as<double>() : 100.0);
+  }
+
   try
   {
+    if(vm.count("trace"))
+      consumer.setTrace(vm["trace"].as<std::string>());
+
+    if(vm.count("cpus"))
+      consumer.setCpus(ndn::parseCpuList(vm["cpus"].as<std::string>()));
+
     consumer.run();
+
+    if(vm.count("results-dir"))
+    {
+      ndn::BenchmarkRecord record(appName);
+      record.setConfig(vm);
+      consumer.addMetrics(record);
+      std::cout << "Results: " << record.write(vm["results-dir"].as<std::string>()) << std::endl;
+    }
   }
   catch (const std::exception& e)
   {
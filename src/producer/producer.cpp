@@ -4,21 +4,48 @@
 #include "boost/program_options.hpp"
 #include "boost/filesystem.hpp"
 #include "../utils/OptionPrinter.hpp"
+#include "../utils/PayloadGenerator.hpp"
+#include "../utils/TraceRecorder.hpp"
+#include "../utils/BackendPool.hpp"
+#include "../utils/DataSigner.hpp"
+#include "../utils/BenchmarkRecord.hpp"
+#include "../utils/PerfCounters.hpp"
+#include "../utils/BusyPollLoop.hpp"
+#include "boost/asio/signal_set.hpp"
+#include "boost/asio/deadline_timer.hpp"
+#include "boost/lexical_cast.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
 
 using namespace boost::program_options;
 
 namespace ndn
 {
 
+const boost::posix_time::milliseconds BATCH_TIMEOUT(10);
+
 class Producer : noncopyable
 {
 public:
 
   Producer(std::string prefix, int data_size, int fresshness_seconds)
+    : m_signals(m_face.getIoService(), SIGINT, SIGTERM)
+    , m_batchTimer(m_face.getIoService())
   {
     this->prefix = prefix;
     this->data_size = data_size;
     this->fresshness_seconds = fresshness_seconds;
+    this->deterministic = false;
+    this->outstanding = 0;
+    this->max_outstanding = 0;
+    this->outstanding_sum = 0;
+    this->backend_requests = 0;
+    this->sign_batch = 1;
+    this->batch_generation = 0;
+    this->stopped = false;
+    this->stage_build = this->stage_sign = this->stage_put = 0;
     dummyContnet = generateContent (data_size);
   }
 
@@ -28,7 +55,47 @@ public:
                              bind(&Producer::onInterest, this, _1, _2),
                              RegisterPrefixSuccessCallback(),
                              bind(&Producer::onRegisterFailed, this, _1, _2));
-    m_face.processEvents();
+
+    // shut down cleanly on SIGINT/SIGTERM, so buffered traces reach the disk
+    m_signals.async_wait(bind(&Producer::onSignal, this, _1));
+
+    if(!signer)
+      signer = make_shared<DataSigner>(m_keyChain, DataSigner::DEFAULT);
+
+    // the Face thread takes the first CPU, the backend workers share the others
+    if(!cpus.empty())
+    {
+      pinCurrentThread(cpus[0]);
+      if(backend && cpus.size() > 1)
+        backend->pinWorkers(std::vector<int>(cpus.begin() + 1, cpus.end()));
+    }
+
+    if(busy_poll)
+      busy_poll->run();
+    else
+      m_face.processEvents();
+
+    signer->printReport(std::cout);
+
+    if(busy_poll)
+      busy_poll->printReport(std::cout);
+
+    if(perf)
+      perf->printReport(std::cout);
+
+    if(backend)
+    {
+      backend->stop();
+      printBackendReport();
+    }
+
+    if(tracer)
+    {
+      uint64_t dropped = tracer->getDropped();
+      tracer.reset(); // drains the rings and closes the trace file
+      if(dropped > 0)
+        std::cerr << "WARNING: Dropped " << dropped << " trace events" << std::endl;
+    }
   }
 
   void setDebug(bool debug)
@@ -36,6 +103,54 @@ public:
     this->debug = debug;
   }
 
+  void setDeterministic(bool deterministic)
+  {
+    this->deterministic = deterministic;
+    if(deterministic)
+      payload.resize (data_size);
+  }
+
+  void setTrace(const std::string& fname)
+  {
+    tracer = make_shared<TraceRecorder>(fname);
+  }
+
+  /** Counts on the calling thread, so call it from the thread that runs run() */
+  void setPerfCounters()
+  {
+    perf = make_shared<PerfCounters>();
+    if(!perf->open())
+      std::cerr << "WARNING: Performance counters unavailable: " << perf->getError() << std::endl;
+
+    stage_build = perf->addStage("build");
+    stage_sign = perf->addStage("sign");
+    stage_put = perf->addStage("put");
+  }
+
+  /** Spins up to spin_budget usec (-1 forever) on the io_service before sleeping */
+  void setBusyPoll(int spin_budget)
+  {
+    busy_poll = make_shared<BusyPollLoop>(m_face.getIoService(), spin_budget);
+  }
+
+  void setCpus(const std::vector<int>& cpus)
+  {
+    this->cpus = cpus;
+  }
+
+  void setSigning(const std::string& algorithm, int batch)
+  {
+    signer = make_shared<DataSigner>(m_keyChain, DataSigner::parseAlgorithm(algorithm));
+    sign_batch = std::max(1, batch);
+  }
+
+  void setBackend(int workers, const std::string& service_time)
+  {
+    if(workers < 1)
+      throw std::invalid_argument("The backend needs at least one worker");
+    backend = make_shared<BackendPool>(workers, ServiceTimeDistribution(service_time));
+  }
+
 private:
 
   std::string generateContent(const int length)
@@ -56,25 +171,163 @@ private:
   {
     if(debug)
       std::cout << "Received Interest: " << interest << std::endl;
+    if(tracer)
+      tracer->record(TRACE_INTEREST_RECEIVED, nameHash(interest.getName()), interest.wireEncode().size());
+
+    if(backend)
+    {
+      // hand the request to the backend, the Face thread keeps accepting Interests meanwhile
+      outstanding++;
+      backend_requests++;
+      outstanding_sum += outstanding;
+      max_outstanding = std::max(max_outstanding, outstanding);
 
+      Name name(interest.getName());
+      uint64_t seed = nameHash(name);
+      backend->submit([this, name, seed] {
+        std::vector<uint8_t> buffer(deterministic ? data_size : 0);
+        shared_ptr<Data> data = makeData(name, seed, buffer);
+        m_face.getIoService().post(bind(&Producer::onBackendDone, this, name, data));
+      });
+      return;
+    }
+
+    shared_ptr<Data> data;
+    {
+      PerfScope scope(perf.get(), stage_build);
+      data = makeData(interest.getName(), deterministic ? nameHash(interest.getName()) : 0, payload);
+    }
+    sendData(interest.getName(), data);
+  }
+
+  /** Builds the unsigned Data packet, safe to call from backend workers */
+  shared_ptr<Data> makeData(const Name& interestName, uint64_t seed, std::vector<uint8_t>& buffer)
+  {
     // Create new name, based on Interest's name
-    Name dataName(interest.getName());
+    Name dataName(interestName);
     dataName.appendVersion();  // add "version" component (current UNIX timestamp in milliseconds)
 
-    //std::string content = generateContent(data_size);
-    std::string content = dummyContnet;
-
     // Create Data packet
     shared_ptr<Data> data = make_shared<Data>();
     data->setName(dataName);
     data->setFreshnessPeriod(time::seconds(fresshness_seconds));
-    data->setContent(reinterpret_cast<const uint8_t*>(content.c_str()), content.size());
 
-    // Sign Data packet with default identity
-    m_keyChain.sign(*data);
+    if(deterministic)
+    {
+      // derive the payload from the Interest's name so consumers can recompute and check it
+      PayloadGenerator::fill(seed, buffer.data(), buffer.size());
+      data->setContent(buffer.data(), buffer.size());
+    }
+    else
+    {
+      //std::string content = generateContent(data_size);
+      const std::string& content = dummyContnet;
+      data->setContent(reinterpret_cast<const uint8_t*>(content.c_str()), content.size());
+    }
+    return data;
+  }
+
+  void onBackendDone(const Name& interestName, shared_ptr<Data> data)
+  {
+    outstanding--;
+    if(stopped)
+      return;
+    sendData(interestName, data);
+  }
+
+  void sendData(const Name& interestName, shared_ptr<Data> data)
+  {
+    if(sign_batch > 1)
+    {
+      // sign once per batch, a partial batch is flushed after BATCH_TIMEOUT
+      batch.push_back(data);
+      batch_names.push_back(interestName);
+      if(batch.size() == 1)
+      {
+        m_batchTimer.expires_from_now(BATCH_TIMEOUT);
+        m_batchTimer.async_wait(bind(&Producer::onBatchTimeout, this, _1, batch_generation));
+      }
+      if(batch.size() >= (size_t) sign_batch)
+        flushBatch();
+      return;
+    }
+
+    // Sign Data packet with the selected algorithm
+    {
+      PerfScope scope(perf.get(), stage_sign);
+      signer->sign(*data);
+    }
+
+    putData(interestName, *data);
+  }
 
+  void putData(const Name& interestName, const Data& data)
+  {
     // Return Data packet
-    m_face.put(*data);
+    {
+      PerfScope scope(perf.get(), stage_put);
+      m_face.put(data);
+    }
+
+    if(tracer)
+      tracer->record(TRACE_DATA_SENT, nameHash(interestName), data.wireEncode().size());
+  }
+
+  void flushBatch()
+  {
+    // cancel() can not recall an expiry that is already queued, the generation check catches it
+    m_batchTimer.cancel();
+    batch_generation++;
+    {
+      PerfScope scope(perf.get(), stage_sign, batch.size());
+      signer->signBatch(batch);
+    }
+
+    for(size_t i = 0; i < batch.size(); i++)
+      putData(batch_names[i], *batch[i]);
+
+    batch.clear();
+    batch_names.clear();
+  }
+
+  void onBatchTimeout(const boost::system::error_code& error, uint64_t generation)
+  {
+    if(error || generation != batch_generation || batch.empty())
+      return;
+
+    flushBatch();
+  }
+
+  void shutdown()
+  {
+    // a partially filled batch is dropped
+    stopped = true;
+    m_signals.cancel();
+    m_batchTimer.cancel();
+    m_face.shutdown();
+  }
+
+  void printBackendReport()
+  {
+    std::cout << "Backend Workers: " << backend->getWorkers() << std::endl;
+    std::cout << "Backend Requests: " << backend_requests << std::endl;
+    std::cout << "Max Outstanding Requests: " << max_outstanding << std::endl;
+    if(backend_requests > 0)
+      std::cout << "Mean Outstanding Requests: " << ((double) outstanding_sum) / (double) backend_requests << std::endl;
+  }
+
+  uint64_t nameHash(const Name& name)
+  {
+    const Block& wire = name.wireEncode();
+    return PayloadGenerator::hash(wire.wire(), wire.size());
+  }
+
+  void onSignal(const boost::system::error_code& error)
+  {
+    if(error)
+      return;
+
+    shutdown();
   }
 
   void onRegisterFailed(const Name& prefix, const std::string& reason)
@@ -83,19 +336,104 @@ private:
       std::cerr << "ERROR: Failed to register prefix \""
                 << prefix << "\" in local hub's daemon (" << reason << ")"
                 << std::endl;
-    m_face.shutdown();
+    shutdown();
   }
 
 private:
   Face m_face;
   KeyChain m_keyChain;
+  boost::asio::signal_set m_signals;
+  boost::asio::deadline_timer m_batchTimer;
   int data_size;
   int fresshness_seconds;
   std::string prefix;
   bool debug;
+  bool deterministic;
   std::string dummyContnet;
+  std::vector<uint8_t> payload;
+  shared_ptr<TraceRecorder> tracer;
+
+  shared_ptr<DataSigner> signer;
+  int sign_batch;
+  std::vector<shared_ptr<Data> > batch;
+  std::vector<Name> batch_names;
+  uint64_t batch_generation; // incremented per flushed batch, invalidates stale timer expiries
+  bool stopped;
+
+  shared_ptr<PerfCounters> perf;
+  size_t stage_build;
+  size_t stage_sign;
+  size_t stage_put;
+
+  shared_ptr<BusyPollLoop> busy_poll;
+  std::vector<int> cpus;
+
+  shared_ptr<BackendPool> backend;
+  unsigned int outstanding;
+  unsigned int max_outstanding;
+  uint64_t outstanding_sum; // sum of outstanding requests seen by each arriving Interest
+  uint64_t backend_requests;
 };
 
+/** Signs count packets with every algorithm, unbatched and in batches of sign_batch */
+void runSignBenchmark(int count, int data_size, int sign_batch, BenchmarkRecord& record)
+{
+  KeyChain keyChain;
+  std::string content(data_size, 'x');
+
+  std::vector<int> batch_sizes;
+  batch_sizes.push_back(1);
+  if(sign_batch > 1)
+    batch_sizes.push_back(sign_batch);
+
+  const char* algorithms[] = {"rsa", "ecdsa", "hmac", "sha256"};
+
+  std::cout << "algorithm,batch,packets,signatures,seconds,packets_per_sec" << std::endl;
+  for(size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++)
+  {
+    for(std::vector<int>::iterator size = batch_sizes.begin(); size != batch_sizes.end(); ++size)
+    {
+      try
+      {
+        DataSigner signer(keyChain, DataSigner::parseAlgorithm(algorithms[a]));
+
+        std::vector<shared_ptr<Data> > batch;
+        for(int i = 0; i < count; i++)
+        {
+          shared_ptr<Data> data = make_shared<Data>(Name("/ndn-apps/sign-benchmark").appendNumber(i));
+          data->setContent(reinterpret_cast<const uint8_t*>(content.c_str()), content.size());
+
+          if(*size == 1)
+            signer.sign(*data);
+          else
+          {
+            batch.push_back(data);
+            if(batch.size() >= (size_t) *size || i == count - 1)
+            {
+              signer.signBatch(batch);
+              batch.clear();
+            }
+          }
+        }
+
+        double seconds = signer.getSeconds();
+        record.addMetric("sign_" + std::string(algorithms[a]) + "_batch" + boost::lexical_cast<std::string>(*size),
+                         seconds > 0 ? signer.getPackets() / seconds : 0, true, "packets/s");
+        std::cout << algorithms[a] << ","
+                  << *size << ","
+                  << signer.getPackets() << ","
+                  << signer.getSignatures() << ","
+                  << seconds << ","
+                  << (seconds > 0 ? signer.getPackets() / seconds : 0) << std::endl;
+      }
+      catch (const std::exception& e)
+      {
+        std::cerr << "ERROR: Signing with " << algorithms[a] << " failed: " << e.what() << std::endl;
+      }
+    }
+  }
+}
+
 } // namespace ndn
 
 int main(int argc, char** argv)
@@ -108,7 +446,18 @@ int main(int argc, char** argv)
       ("prefix,p", value<std::string>()->required (), "Prefix the Producer listens too. (Required)")
       ("data-size,s", value<int>()->required (), "The size of the datapacket in bytes. (Required)")
       ("freshness-time,f", value<int>(), "Freshness time of the content in seconds. (Default 5min)")
-      ("debug,v", "Enables Debug.");
+      ("deterministic,d", "Derives the payload from a hash of the Interest name, so consumers can verify it. (Optional)")
+      ("backend-workers,w", value<int>(), "Builds Data asynchronously on N emulated backend workers. (Optional)")
+      ("service-time", value<std::string>(), "Backend service time: fixed:USEC, exp:MEAN_USEC or hist:FILE. (Default fixed:0)")
+      ("sign", value<std::string>(), "Signing algorithm: default, rsa, ecdsa, hmac or sha256. (Default default)")
+      ("sign-batch", value<int>(), "Signs one Merkle root per batch of N Data packets. (Default 1, no batching)")
+      ("sign-benchmark", value<int>(), "Signs N packets with every algorithm, prints the throughput and exits. (Optional)")
+      ("results-dir,R", value<std::string>(), "Stores a benchmark record of --sign-benchmark in this directory. (Optional)")
+      ("perf-counters,P", "Reports hardware performance counters per packet for build, sign and put at exit. (Optional)")
+      ("busy-poll,B", value<int>(), "Polls the Face for USEC after the last event before sleeping, -1 never sleeps. (Optional)")
+      ("cpus,C", value<std::string>(), "Pins the Face thread to the first CPU of the list (e.g. 2,4-6), backend workers to the others. (Optional)")
+      ("debug,v", "Enables Debug.")
+      ("trace,T", value<std::string>(), "Writes a binary event trace to this file, decode it with trace-decoder. (Optional)");
 
   positional_options_description positionalOptions;
   variables_map vm;
@@ -156,6 +505,28 @@ int main(int argc, char** argv)
     return -1;
   }
 
+  if(vm.count ("sign-benchmark"))
+  {
+    try
+    {
+      ndn::BenchmarkRecord record(appName + "-sign-benchmark");
+      record.setConfig(vm);
+      ndn::runSignBenchmark(vm["sign-benchmark"].as<int>(),
+                            vm["data-size"].as<int>(),
+                            vm.count ("sign-batch") ? vm["sign-batch"].as<int>() : 1,
+                            record);
+
+      if(vm.count ("results-dir"))
+        std::cout << "Results: " << record.write(vm["results-dir"].as<std::string>()) << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return -1;
+    }
+    return 0;
+  }
+
   int freshness_time = 300;
   if(vm.count ("freshness-time"))
   {
@@ -171,8 +542,39 @@ int main(int argc, char** argv)
   else
     producer.setDebug (false);
 
+  if(vm.count ("deterministic"))
+    producer.setDeterministic (true);
+
   try
   {
+    if(vm.count ("trace"))
+      producer.setTrace (vm["trace"].as<std::string>());
+
+    if(vm.count ("busy-poll"))
+      producer.setBusyPoll (vm["busy-poll"].as<int>());
+
+    if(vm.count ("cpus"))
+      producer.setCpus (ndn::parseCpuList(vm["cpus"].as<std::string>()));
+
+    if(vm.count ("perf-counters"))
+      producer.setPerfCounters ();
+
+    if(vm.count ("sign") || vm.count ("sign-batch"))
+    {
+      std::string algorithm = "default";
+      if(vm.count ("sign"))
+        algorithm = vm["sign"].as<std::string>();
+      producer.setSigning (algorithm, vm.count ("sign-batch") ? vm["sign-batch"].as<int>() : 1);
+    }
+
+    if(vm.count ("backend-workers"))
+    {
+      std::string service_time = "fixed:0";
+      if(vm.count ("service-time"))
+        service_time = vm["service-time"].as<std::string>();
+      producer.setBackend (vm["backend-workers"].as<int>(), service_time);
+    }
+
     producer.run();
   }
   catch (const std::exception& e)
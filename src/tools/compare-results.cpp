@@ -0,0 +1,259 @@
+#include "boost/program_options.hpp"
+#include "boost/filesystem.hpp"
+#include "../utils/OptionPrinter.hpp"
+#include "../utils/BenchmarkRecord.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace boost::program_options;
+
+namespace ndn
+{
+
+/** A metric of the baseline, averaged over all baseline records that have it */
+struct BaselineMetric
+{
+  double value;
+  double spread; // run to run standard deviation, needs two or more records
+  double error;  // mean standard error within the runs
+  size_t runs;
+};
+
+void compareProperties(const BenchmarkRecord::Properties& baseline, const BenchmarkRecord::Properties& run,
+                       const std::string& what, std::ostream& os)
+{
+  for(BenchmarkRecord::Properties::const_iterator it = run.begin(); it != run.end(); ++it)
+  {
+    BenchmarkRecord::Properties::const_iterator base = baseline.find(it->first);
+    if(base == baseline.end() || base->second != it->second)
+      os << what << " differs: " << it->first << " = " << it->second
+         << " (baseline " << (base == baseline.end() ? "unset" : base->second) << ")" << std::endl;
+  }
+  for(BenchmarkRecord::Properties::const_iterator it = baseline.begin(); it != baseline.end(); ++it)
+  {
+    if(run.find(it->first) == run.end())
+      os << what << " differs: " << it->first << " unset (baseline " << it->second << ")" << std::endl;
+  }
+}
+
+std::map<std::string, BaselineMetric> aggregateBaselines(const std::vector<BenchmarkRecord>& baselines)
+{
+  std::map<std::string, std::vector<double> > values;
+  std::map<std::string, double> errors;
+  for(std::vector<BenchmarkRecord>::const_iterator record = baselines.begin(); record != baselines.end(); ++record)
+  {
+    const BenchmarkRecord::Metrics& metrics = record->getMetrics();
+    for(BenchmarkRecord::Metrics::const_iterator it = metrics.begin(); it != metrics.end(); ++it)
+    {
+      values[it->first].push_back(it->second.value);
+      errors[it->first] += it->second.error;
+    }
+  }
+
+  std::map<std::string, BaselineMetric> aggregated;
+  for(std::map<std::string, std::vector<double> >::const_iterator it = values.begin(); it != values.end(); ++it)
+  {
+    BaselineMetric& metric = aggregated[it->first];
+    BenchmarkRecord::computeStats(it->second, metric.value, metric.spread);
+    metric.runs = it->second.size();
+    metric.error = errors[it->first] / metric.runs;
+  }
+  return aggregated;
+}
+
+/**
+ * Compares the metrics of a run with the mean of one or more baseline records.
+ *
+ * A change only counts if it exceeds both the relative threshold and sigma times the noise.
+ * With two or more baseline records the noise is their run to run spread; with a single
+ * record only the within-run errors are known, which understate it. Returns the number of
+ * regressions.
+ */
+int compareRecords(const std::vector<BenchmarkRecord>& baselines, const BenchmarkRecord& run,
+                   double threshold, double sigma, std::ostream& os)
+{
+  const BenchmarkRecord& first = baselines.front();
+  for(std::vector<BenchmarkRecord>::const_iterator it = baselines.begin(); it != baselines.end(); ++it)
+  {
+    if(it->getApp() != run.getApp())
+      os << "WARNING: Comparing records of different apps (" << it->getApp()
+         << " vs " << run.getApp() << ")" << std::endl;
+    if(it != baselines.begin() && (it->getConfig() != first.getConfig() || it->getHost() != first.getHost()))
+      os << "WARNING: Baseline of " << it->getTimestamp()
+         << " differs in config or host from the first baseline, its spread is no run to run noise" << std::endl;
+  }
+
+  // differing configurations or hosts usually explain large changes
+  compareProperties(first.getConfig(), run.getConfig(), "Config", os);
+  compareProperties(first.getHost(), run.getHost(), "Host", os);
+
+  if(baselines.size() > 1)
+    os << "Noise: run to run spread of " << baselines.size() << " baseline records" << std::endl;
+  else
+    os << "Noise: within-run errors only, pass several baseline records for run to run noise" << std::endl;
+
+  os << std::left << std::setw(28) << "metric"
+     << std::right << std::setw(14) << "baseline"
+     << std::setw(14) << "run"
+     << std::setw(10) << "change%"
+     << std::setw(12) << "allowed%"
+     << "  status" << std::endl;
+
+  int regressions = 0;
+  std::map<std::string, BaselineMetric> baseMetrics = aggregateBaselines(baselines);
+  const BenchmarkRecord::Metrics& runMetrics = run.getMetrics();
+  for(BenchmarkRecord::Metrics::const_iterator it = runMetrics.begin(); it != runMetrics.end(); ++it)
+  {
+    std::map<std::string, BaselineMetric>::const_iterator base = baseMetrics.find(it->first);
+    if(base == baseMetrics.end())
+    {
+      os << std::left << std::setw(28) << it->first
+         << std::right << std::setw(14) << "-"
+         << std::setw(14) << it->second.value
+         << std::setw(10) << "-"
+         << std::setw(12) << "-"
+         << "  only in run" << std::endl;
+      continue;
+    }
+
+    const BaselineMetric& b = base->second;
+    const BenchmarkMetric& r = it->second;
+
+    // the run is one sample of the baseline distribution, compared with the mean of b.runs samples
+    double noise;
+    if(b.runs > 1)
+      noise = sigma * b.spread * std::sqrt(1.0 + 1.0 / b.runs);
+    else
+      noise = sigma * std::sqrt(b.error * b.error + r.error * r.error);
+
+    double delta = r.value - b.value;
+    double allowed = std::max(std::fabs(b.value) * threshold / 100.0, noise);
+
+    double change = b.value != 0 ? delta / std::fabs(b.value) * 100.0 : 0;
+    double allowedPercent = b.value != 0 ? allowed / std::fabs(b.value) * 100.0 : 0;
+
+    const char* status = "ok";
+    if(std::fabs(delta) > allowed)
+    {
+      bool better = r.higherIsBetter ? delta > 0 : delta < 0;
+      status = better ? "improved" : "REGRESSION";
+      if(!better)
+        regressions++;
+    }
+
+    os << std::left << std::setw(28) << it->first
+       << std::right << std::setw(14) << b.value
+       << std::setw(14) << r.value
+       << std::setw(10) << std::fixed << std::setprecision(2) << change
+       << std::setw(12) << allowedPercent
+       << std::resetiosflags(std::ios::floatfield) << std::setprecision(6)
+       << "  " << status << std::endl;
+  }
+
+  for(std::map<std::string, BaselineMetric>::const_iterator it = baseMetrics.begin(); it != baseMetrics.end(); ++it)
+  {
+    if(runMetrics.find(it->first) == runMetrics.end())
+      os << std::left << std::setw(28) << it->first
+         << std::right << std::setw(14) << it->second.value
+         << std::setw(14) << "-"
+         << std::setw(10) << "-"
+         << std::setw(12) << "-"
+         << "  only in baseline" << std::endl;
+  }
+
+  return regressions;
+}
+
+} // namespace ndn
+
+int main(int argc, char** argv)
+{
+  std::string appName = boost::filesystem::basename(argv[0]);
+
+  options_description desc("Programm Options");
+  desc.add_options ()
+      ("help,h", "Prints help.")
+      ("baseline,b", value<std::vector<std::string> >()->multitoken()->required (), "Baseline records, e.g. repeated runs of the last release; two or more give run to run noise. (Required)")
+      ("run,r", value<std::string>()->required (), "Record of the run to check. (Required)")
+      ("threshold,t", value<double>(), "Relative change in percent that is always tolerated. (Default 5%)")
+      ("sigma,s", value<double>(), "Tolerated change in multiples of the run noise. (Default 3)");
+
+  positional_options_description positionalOptions;
+  variables_map vm;
+
+  try
+  {
+    store(command_line_parser(argc, argv).options(desc)
+                .positional(positionalOptions).run(),
+              vm); // throws on error
+
+    if ( vm.count("help")  )
+    {
+
+      rad::OptionPrinter::printStandardAppDesc(appName,
+                                               std::cout,
+                                               desc,
+                                               &positionalOptions);
+      return 0;
+    }
+    notify(vm); //notify if required parameters are not provided.
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    rad::OptionPrinter::formatRequiredOptionError(e);
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    rad::OptionPrinter::printStandardAppDesc(appName,
+                                             std::cout,
+                                             desc,
+                                             &positionalOptions);
+    return -1;
+  }
+  catch(boost::program_options::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    rad::OptionPrinter::printStandardAppDesc(appName,
+                                             std::cout,
+                                             desc,
+                                             &positionalOptions);
+    return -1;
+  }
+  catch(std::exception& e)
+  {
+    std::cerr << "Unhandled Exception reached the top of main: "
+              << e.what() << ", application will now exit" << std::endl;
+    return -1;
+  }
+
+  double threshold = 5;
+  if(vm.count ("threshold"))
+    threshold = vm["threshold"].as<double>();
+
+  double sigma = 3;
+  if(vm.count ("sigma"))
+    sigma = vm["sigma"].as<double>();
+
+  int regressions;
+  try
+  {
+    std::vector<ndn::BenchmarkRecord> baselines;
+    std::vector<std::string> fnames = vm["baseline"].as<std::vector<std::string> >();
+    for(std::vector<std::string>::const_iterator it = fnames.begin(); it != fnames.end(); ++it)
+      baselines.push_back(ndn::BenchmarkRecord::read(*it));
+    ndn::BenchmarkRecord run = ndn::BenchmarkRecord::read(vm["run"].as<std::string>());
+    regressions = ndn::compareRecords(baselines, run, threshold, sigma, std::cout);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return -1;
+  }
+
+  std::cout << "Regressions: " << regressions << std::endl;
+
+  // a non-zero exit status lets scripts stop a deployment on regressions
+  return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+#include "boost/program_options.hpp"
+#include "boost/filesystem.hpp"
+#include "../utils/OptionPrinter.hpp"
+#include "../utils/TraceRecorder.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+
+using namespace boost::program_options;
+
+namespace ndn
+{
+
+const char* traceEventName(uint16_t type)
+{
+  switch(type)
+  {
+    case TRACE_INTEREST_SENT: return "InterestSent";
+    case TRACE_INTEREST_RECEIVED: return "InterestReceived";
+    case TRACE_DATA_SENT: return "DataSent";
+    case TRACE_DATA_RECEIVED: return "DataReceived";
+    case TRACE_TIMEOUT: return "Timeout";
+    case TRACE_RETRANSMISSION: return "Retransmission";
+    default: return "Unknown";
+  }
+}
+
+/** Converts a binary trace into CSV, returns the number of decoded records or -1 on error */
+long decodeTrace(std::istream& input, std::ostream& output, bool relative)
+{
+  TraceHeader header;
+  if(!input.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+     std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0)
+  {
+    std::cerr << "ERROR: Not a trace file" << std::endl;
+    return -1;
+  }
+
+  if(header.version != TRACE_VERSION || header.recordSize != sizeof(TraceEvent))
+  {
+    std::cerr << "ERROR: Unsupported trace version " << header.version
+              << " (record size " << header.recordSize << ")" << std::endl;
+    return -1;
+  }
+
+  output << "timestamp_ns,thread,event,id,size" << "\n";
+
+  // records of different threads are interleaved per drain, so they are not strictly ordered
+  TraceEvent event;
+  uint64_t start = 0;
+  long records = 0;
+  char id[17];
+  while(input.read(reinterpret_cast<char*>(&event), sizeof(event)))
+  {
+    if(records == 0)
+      start = event.timestamp;
+
+    snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(event.id));
+    output << (relative ? static_cast<int64_t>(event.timestamp - start) : static_cast<int64_t>(event.timestamp))
+           << "," << event.thread
+           << "," << traceEventName(event.type)
+           << "," << id
+           << "," << event.size << "\n";
+    records++;
+  }
+
+  if(input.gcount() != 0)
+    std::cerr << "WARNING: Trace ends with a truncated record" << std::endl;
+
+  return records;
+}
+
+} // namespace ndn
+
+int main(int argc, char** argv)
+{
+  std::string appName = boost::filesystem::basename(argv[0]);
+
+  options_description desc("Programm Options");
+  desc.add_options ()
+      ("help,h", "Prints help.")
+      ("input,i", value<std::string>()->required (), "Binary trace written by --trace. (Required)")
+      ("output,o", value<std::string>(), "Writes the CSV to this file instead of stdout. (Optional)")
+      ("relative,r", "Prints timestamps relative to the first record. (Optional)");
+
+  positional_options_description positionalOptions;
+  variables_map vm;
+
+  try
+  {
+    store(command_line_parser(argc, argv).options(desc)
+                .positional(positionalOptions).run(),
+              vm); // throws on error
+
+    if ( vm.count("help")  )
+    {
+
+      rad::OptionPrinter::printStandardAppDesc(appName,
+                                               std::cout,
+                                               desc,
+                                               &positionalOptions);
+      return 0;
+    }
+    notify(vm); //notify if required parameters are not provided.
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    rad::OptionPrinter::formatRequiredOptionError(e);
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    rad::OptionPrinter::printStandardAppDesc(appName,
+                                             std::cout,
+                                             desc,
+                                             &positionalOptions);
+    return -1;
+  }
+  catch(boost::program_options::error& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    rad::OptionPrinter::printStandardAppDesc(appName,
+                                             std::cout,
+                                             desc,
+                                             &positionalOptions);
+    return -1;
+  }
+  catch(std::exception& e)
+  {
+    std::cerr << "Unhandled Exception reached the top of main: "
+              << e.what() << ", application will now exit" << std::endl;
+    return -1;
+  }
+
+  std::string fname = vm["input"].as<std::string>();
+  std::ifstream input(fname.c_str(), std::ios::binary);
+  if(!input)
+  {
+    std::cerr << "ERROR: Can not open " << fname << std::endl;
+    return -1;
+  }
+
+  long records;
+  if(vm.count ("output"))
+  {
+    std::string oname = vm["output"].as<std::string>();
+    std::ofstream output(oname.c_str());
+    if(!output)
+    {
+      std::cerr << "ERROR: Can not open " << oname << std::endl;
+      return -1;
+    }
+    records = ndn::decodeTrace(input, output, vm.count("relative") > 0);
+  }
+  else
+    records = ndn::decodeTrace(input, std::cout, vm.count("relative") > 0);
+
+  if(records < 0)
+    return -1;
+
+  std::cerr << "Decoded " << records << " records" << std::endl;
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include "BackendPool.hpp"
+#include "BusyPollLoop.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace ndn
+{
+
+ServiceTimeDistribution::ServiceTimeDistribution(const std::string& spec)
+  : spec(spec)
+  , type(FIXED)
+  , mean(0)
+{
+  size_t colon = spec.find(':');
+  if (colon == std::string::npos)
+    throw std::invalid_argument("Invalid service time \"" + spec + "\", expected TYPE:VALUE");
+
+  std::string kind = spec.substr(0, colon);
+  std::string argument = spec.substr(colon + 1);
+
+  if (kind == "hist")
+  {
+    type = HISTOGRAM;
+    loadHistogram(argument);
+    return;
+  }
+
+  std::istringstream is(argument);
+  if (!(is >> mean) || mean < 0)
+    throw std::invalid_argument("Invalid service time \"" + spec + "\", expected a non-negative value");
+
+  if (kind == "fixed")
+    type = FIXED;
+  else if (kind == "exp")
+    type = EXPONENTIAL;
+  else
+    throw std::invalid_argument("Unknown service time distribution \"" + kind + "\"");
+}
+
+void ServiceTimeDistribution::loadHistogram(const std::string& fname)
+{
+  std::ifstream input(fname.c_str());
+  if (!input)
+    throw std::invalid_argument("Can not open service time histogram " + fname);
+
+  double total = 0;
+  std::string line;
+  while (std::getline(input, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream is(line);
+    uint64_t value;
+    double weight;
+    if (!(is >> value >> weight) || weight < 0)
+      throw std::invalid_argument("Invalid line in service time histogram " + fname + ": " + line);
+
+    total += weight;
+    values.push_back(value);
+    cumulativeWeights.push_back(total);
+    mean += value * weight;
+  }
+
+  if (total <= 0)
+    throw std::invalid_argument("Service time histogram " + fname + " is empty");
+  mean /= total;
+}
+
+uint64_t ServiceTimeDistribution::sample(std::mt19937_64& rng) const
+{
+  switch (type)
+  {
+    case EXPONENTIAL:
+    {
+      if (mean <= 0)
+        return 0;
+      std::exponential_distribution<double> distribution(1.0 / mean);
+      return static_cast<uint64_t>(distribution(rng));
+    }
+    case HISTOGRAM:
+    {
+      std::uniform_real_distribution<double> distribution(0, cumulativeWeights.back());
+      size_t index = std::upper_bound(cumulativeWeights.begin(), cumulativeWeights.end(), distribution(rng))
+                     - cumulativeWeights.begin();
+      return values[std::min(index, values.size() - 1)];
+    }
+    case FIXED:
+    default:
+      return static_cast<uint64_t>(mean);
+  }
+}
+
+const std::string& ServiceTimeDistribution::getSpec() const
+{
+  return spec;
+}
+
+BackendPool::BackendPool(size_t workers, const ServiceTimeDistribution& serviceTime)
+  : serviceTime(serviceTime)
+  , stopped(false)
+{
+  for (size_t i = 0; i < workers; ++i)
+    this->workers.push_back(std::thread(&BackendPool::workerLoop, this, i));
+}
+
+BackendPool::~BackendPool()
+{
+  stop();
+}
+
+void BackendPool::submit(const Job& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(job);
+  }
+  condition.notify_one();
+}
+
+void BackendPool::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopped)
+      return;
+    stopped = true;
+    jobs.clear();
+  }
+  condition.notify_all();
+
+  for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+    it->join();
+}
+
+void BackendPool::pinWorkers(const std::vector<int>& cpus)
+{
+  if (cpus.empty())
+    return;
+
+  for (size_t i = 0; i < workers.size(); ++i)
+    pinThread(workers[i], cpus[i % cpus.size()]);
+}
+
+size_t BackendPool::getWorkers() const
+{
+  return workers.size();
+}
+
+void BackendPool::workerLoop(size_t index)
+{
+  std::random_device seed;
+  std::mt19937_64 rng(seed() + index);
+
+  while (true)
+  {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!stopped && jobs.empty())
+        condition.wait(lock);
+      if (stopped)
+        return;
+      job = jobs.front();
+      jobs.pop_front();
+    }
+
+    // each worker serves one request at a time, like a synchronous backend call
+    uint64_t usec = serviceTime.sample(rng);
+    if (usec > 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(usec));
+
+    job();
+  }
+}
+
+} // namespace ndn
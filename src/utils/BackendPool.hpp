@@ -0,0 +1,95 @@
+#ifndef NDN_APPS_BACKENDPOOL_HPP
+#define NDN_APPS_BACKENDPOOL_HPP
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace ndn
+{
+
+/**
+ * Service time distribution of an emulated backend, in microseconds.
+ *
+ * Specified as "fixed:USEC", "exp:MEAN_USEC" or "hist:FILE". A histogram file holds one
+ * "USEC WEIGHT" pair per line, lines starting with '#' are ignored.
+ */
+class ServiceTimeDistribution
+{
+public:
+  enum Type
+  {
+    FIXED,
+    EXPONENTIAL,
+    HISTOGRAM
+  };
+
+  /** Throws std::invalid_argument if the specification can not be parsed */
+  explicit ServiceTimeDistribution(const std::string& spec);
+
+  uint64_t sample(std::mt19937_64& rng) const;
+
+  const std::string& getSpec() const;
+
+private:
+  void loadHistogram(const std::string& fname);
+
+private:
+  std::string spec;
+  Type type;
+  double mean;
+  std::vector<uint64_t> values;
+  std::vector<double> cumulativeWeights;
+};
+
+/**
+ * Pool of worker threads emulating a slow backend.
+ *
+ * Every submitted job first waits for a service time drawn from the distribution, then runs
+ * on the worker. Jobs complete out of order; posting results back is up to the job.
+ */
+class BackendPool
+{
+public:
+  typedef std::function<void()> Job;
+
+  BackendPool(size_t workers, const ServiceTimeDistribution& serviceTime);
+
+  /** Stops the workers, jobs still queued are discarded */
+  ~BackendPool();
+
+  void submit(const Job& job);
+  void stop();
+
+  /** Pins the workers round-robin to cpus, throws std::runtime_error on failure */
+  void pinWorkers(const std::vector<int>& cpus);
+
+  size_t getWorkers() const;
+
+private:
+  void workerLoop(size_t index);
+
+  BackendPool(const BackendPool&);
+  BackendPool& operator=(const BackendPool&);
+
+private:
+  ServiceTimeDistribution serviceTime;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<Job> jobs;
+  bool stopped;
+
+  std::vector<std::thread> workers;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_BACKENDPOOL_HPP
@@ -0,0 +1,252 @@
+#include "BenchmarkRecord.hpp"
+
+#include "boost/filesystem.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/property_tree/ptree.hpp"
+#include "boost/property_tree/json_parser.hpp"
+
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace ndn
+{
+
+namespace
+{
+  const int RECORD_VERSION = 2;
+
+  // output paths change between runs without changing what is measured
+  const char* OUTPUT_OPTIONS[] = {"results-dir", "logfile", "trace"};
+
+  bool isOutputOption(const std::string& name)
+  {
+    for (size_t i = 0; i < sizeof(OUTPUT_OPTIONS) / sizeof(OUTPUT_OPTIONS[0]); ++i)
+    {
+      if (name == OUTPUT_OPTIONS[i])
+        return true;
+    }
+    return false;
+  }
+
+  std::string optionValueToString(const boost::any& value)
+  {
+    if (value.empty())
+      return "true";
+    if (const int* v = boost::any_cast<int>(&value))
+      return boost::lexical_cast<std::string>(*v);
+    if (const double* v = boost::any_cast<double>(&value))
+      return boost::lexical_cast<std::string>(*v);
+    if (const std::string* v = boost::any_cast<std::string>(&value))
+      return v->empty() ? "true" : *v;
+    return "true"; // switches without a value
+  }
+
+  std::string readCpuModel()
+  {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+      if (line.compare(0, 10, "model name") == 0)
+      {
+        size_t colon = line.find(':');
+        if (colon != std::string::npos && colon + 2 <= line.size())
+          return line.substr(colon + 2);
+      }
+    }
+    return "unknown";
+  }
+
+  boost::property_tree::ptree toTree(const BenchmarkRecord::Properties& properties)
+  {
+    boost::property_tree::ptree tree;
+    for (BenchmarkRecord::Properties::const_iterator it = properties.begin(); it != properties.end(); ++it)
+      tree.put_child(boost::property_tree::ptree::path_type(it->first, '/'),
+                     boost::property_tree::ptree(it->second));
+    return tree;
+  }
+
+  void fromTree(const boost::property_tree::ptree& tree, BenchmarkRecord::Properties& properties)
+  {
+    for (boost::property_tree::ptree::const_iterator it = tree.begin(); it != tree.end(); ++it)
+      properties[it->first] = it->second.data();
+  }
+
+} // namespace
+
+BenchmarkRecord::BenchmarkRecord()
+{
+}
+
+BenchmarkRecord::BenchmarkRecord(const std::string& app)
+  : app(app)
+{
+  char buffer[32];
+  time_t now = time(NULL);
+  strftime(buffer, sizeof(buffer), "%Y%m%d-%H%M%S", gmtime(&now));
+  timestamp = buffer;
+
+  collectHostInfo();
+}
+
+void BenchmarkRecord::setConfig(const boost::program_options::variables_map& vm)
+{
+  for (boost::program_options::variables_map::const_iterator it = vm.begin(); it != vm.end(); ++it)
+  {
+    if (!isOutputOption(it->first))
+      config[it->first] = optionValueToString(it->second.value());
+  }
+}
+
+void BenchmarkRecord::setConfig(const std::string& key, const std::string& value)
+{
+  config[key] = value;
+}
+
+void BenchmarkRecord::addMetric(const std::string& name, double value, bool higherIsBetter,
+                                const std::string& unit, double error)
+{
+  BenchmarkMetric metric;
+  metric.value = value;
+  metric.error = error;
+  metric.higherIsBetter = higherIsBetter;
+  metric.unit = unit;
+  metrics[name] = metric;
+}
+
+std::string BenchmarkRecord::write(const std::string& directory) const
+{
+  boost::filesystem::create_directories(directory);
+
+  boost::property_tree::ptree tree;
+  tree.put("version", RECORD_VERSION);
+  tree.put("app", app);
+  tree.put("timestamp", timestamp);
+  tree.put_child("config", toTree(config));
+  tree.put_child("host", toTree(host));
+
+  boost::property_tree::ptree metricsTree;
+  for (Metrics::const_iterator it = metrics.begin(); it != metrics.end(); ++it)
+  {
+    boost::property_tree::ptree metric;
+    metric.put("value", it->second.value);
+    metric.put("error", it->second.error);
+    metric.put("better", it->second.higherIsBetter ? "higher" : "lower");
+    metric.put("unit", it->second.unit);
+    metricsTree.put_child(boost::property_tree::ptree::path_type(it->first, '/'), metric);
+  }
+  tree.put_child("metrics", metricsTree);
+
+  // never overwrite an existing record
+  std::string base = app + "-" + timestamp + "-" + boost::lexical_cast<std::string>(getpid());
+  boost::filesystem::path fname = boost::filesystem::path(directory) / (base + ".json");
+  for (int i = 1; boost::filesystem::exists(fname); i++)
+    fname = boost::filesystem::path(directory) / (base + "-" + boost::lexical_cast<std::string>(i) + ".json");
+
+  boost::property_tree::write_json(fname.string(), tree);
+  return fname.string();
+}
+
+BenchmarkRecord BenchmarkRecord::read(const std::string& fname)
+{
+  boost::property_tree::ptree tree;
+  try
+  {
+    boost::property_tree::read_json(fname, tree);
+  }
+  catch (const boost::property_tree::json_parser_error& e)
+  {
+    throw std::runtime_error("Can not read benchmark record " + fname + ": " + e.what());
+  }
+
+  if (tree.get<int>("version", 0) != RECORD_VERSION)
+    throw std::runtime_error("Unsupported benchmark record version in " + fname);
+
+  BenchmarkRecord record;
+  record.app = tree.get<std::string>("app", "");
+  record.timestamp = tree.get<std::string>("timestamp", "");
+  fromTree(tree.get_child("config", boost::property_tree::ptree()), record.config);
+  fromTree(tree.get_child("host", boost::property_tree::ptree()), record.host);
+
+  boost::property_tree::ptree metricsTree = tree.get_child("metrics", boost::property_tree::ptree());
+  for (boost::property_tree::ptree::const_iterator it = metricsTree.begin(); it != metricsTree.end(); ++it)
+  {
+    record.addMetric(it->first,
+                     it->second.get<double>("value"),
+                     it->second.get<std::string>("better", "higher") == "higher",
+                     it->second.get<std::string>("unit", ""),
+                     it->second.get<double>("error", 0));
+  }
+  return record;
+}
+
+void BenchmarkRecord::collectHostInfo()
+{
+  char hostname[256] = "unknown";
+  gethostname(hostname, sizeof(hostname) - 1);
+  host["hostname"] = hostname;
+
+  struct utsname name;
+  if (uname(&name) == 0)
+  {
+    host["os"] = name.sysname;
+    host["kernel"] = name.release;
+    host["machine"] = name.machine;
+  }
+
+  host["cpu"] = readCpuModel();
+  host["cores"] = boost::lexical_cast<std::string>(std::thread::hardware_concurrency());
+}
+
+const std::string& BenchmarkRecord::getApp() const
+{
+  return app;
+}
+
+const std::string& BenchmarkRecord::getTimestamp() const
+{
+  return timestamp;
+}
+
+const BenchmarkRecord::Properties& BenchmarkRecord::getConfig() const
+{
+  return config;
+}
+
+const BenchmarkRecord::Properties& BenchmarkRecord::getHost() const
+{
+  return host;
+}
+
+const BenchmarkRecord::Metrics& BenchmarkRecord::getMetrics() const
+{
+  return metrics;
+}
+
+void BenchmarkRecord::computeStats(const std::vector<double>& samples, double& mean, double& stddev)
+{
+  mean = 0;
+  stddev = 0;
+  if (samples.empty())
+    return;
+
+  for (std::vector<double>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+    mean += *it;
+  mean /= samples.size();
+
+  if (samples.size() < 2)
+    return;
+
+  double sum = 0;
+  for (std::vector<double>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+    sum += (*it - mean) * (*it - mean);
+  stddev = std::sqrt(sum / (samples.size() - 1));
+}
+
+} // namespace ndn
@@ -0,0 +1,72 @@
+#ifndef NDN_APPS_BENCHMARKRECORD_HPP
+#define NDN_APPS_BENCHMARKRECORD_HPP
+
+#include "boost/program_options.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ndn
+{
+
+/** A single measured value of a benchmark run */
+struct BenchmarkMetric
+{
+  double value;
+  double error; // standard error within the run, 0 if unknown; not a run to run noise estimate
+  bool higherIsBetter;
+  std::string unit;
+};
+
+/**
+ * Structured result of one benchmark run: configuration, host information and metrics.
+ *
+ * Records are stored as JSON files in a results directory and compared with compare-results.
+ * Run to run noise is only known from several records of the same configuration.
+ */
+class BenchmarkRecord
+{
+public:
+  typedef std::map<std::string, std::string> Properties;
+  typedef std::map<std::string, BenchmarkMetric> Metrics;
+
+  BenchmarkRecord();
+  explicit BenchmarkRecord(const std::string& app);
+
+  /** Stores the options of the command line as configuration, except output paths */
+  void setConfig(const boost::program_options::variables_map& vm);
+  void setConfig(const std::string& key, const std::string& value);
+
+  void addMetric(const std::string& name, double value, bool higherIsBetter,
+                 const std::string& unit, double error = 0);
+
+  /** Writes the record as <directory>/<app>-<timestamp>-<pid>.json, returns the file name */
+  std::string write(const std::string& directory) const;
+
+  /** Throws std::runtime_error if the file is not a valid record */
+  static BenchmarkRecord read(const std::string& fname);
+
+  const std::string& getApp() const;
+  const std::string& getTimestamp() const;
+  const Properties& getConfig() const;
+  const Properties& getHost() const;
+  const Metrics& getMetrics() const;
+
+  /** Returns mean and standard deviation of samples */
+  static void computeStats(const std::vector<double>& samples, double& mean, double& stddev);
+
+private:
+  void collectHostInfo();
+
+private:
+  std::string app;
+  std::string timestamp;
+  Properties config;
+  Properties host;
+  Metrics metrics;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_BENCHMARKRECORD_HPP
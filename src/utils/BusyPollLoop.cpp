@@ -0,0 +1,143 @@
+#include "BusyPollLoop.hpp"
+
+#include "boost/lexical_cast.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ndn
+{
+
+namespace
+{
+  inline void cpuRelax()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  void setAffinity(pthread_t thread, int cpu)
+  {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int error = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (error != 0)
+      throw std::runtime_error("Can not pin thread to CPU " + boost::lexical_cast<std::string>(cpu) +
+                               ": " + strerror(error));
+#else
+    (void) thread;
+    throw std::runtime_error("Can not pin thread to CPU " + boost::lexical_cast<std::string>(cpu) +
+                             ": not supported on this platform");
+#endif
+  }
+
+} // namespace
+
+std::vector<int> parseCpuList(const std::string& list)
+{
+  std::vector<int> cpus;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ','))
+  {
+    try
+    {
+      size_t dash = range.find('-');
+      int first = boost::lexical_cast<int>(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : boost::lexical_cast<int>(range.substr(dash + 1));
+      if (first < 0 || last < first)
+        throw std::invalid_argument(range);
+      for (int cpu = first; cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    }
+    catch (const boost::bad_lexical_cast&)
+    {
+      throw std::invalid_argument("Invalid CPU list \"" + list + "\"");
+    }
+    catch (const std::invalid_argument&)
+    {
+      throw std::invalid_argument("Invalid CPU list \"" + list + "\"");
+    }
+  }
+
+  if (cpus.empty())
+    throw std::invalid_argument("Empty CPU list");
+  return cpus;
+}
+
+void pinCurrentThread(int cpu)
+{
+  setAffinity(pthread_self(), cpu);
+}
+
+void pinThread(std::thread& thread, int cpu)
+{
+  setAffinity(thread.native_handle(), cpu);
+}
+
+BusyPollLoop::BusyPollLoop(boost::asio::io_service& ioService, int64_t spinBudget)
+  : ioService(ioService)
+  , spinBudget(spinBudget)
+  , handlers(0)
+  , polls(0)
+  , emptyPolls(0)
+  , sleeps(0)
+{
+}
+
+void BusyPollLoop::run()
+{
+  if (ioService.stopped())
+    ioService.reset();
+
+  std::chrono::steady_clock::time_point lastActivity = std::chrono::steady_clock::now();
+  while (!ioService.stopped())
+  {
+    size_t ran = ioService.poll();
+    polls++;
+    if (ran > 0)
+    {
+      handlers += ran;
+      lastActivity = std::chrono::steady_clock::now();
+      continue;
+    }
+
+    // poll() stops the io_service once it is out of work
+    if (ioService.stopped())
+      break;
+
+    emptyPolls++;
+    if (spinBudget < 0 ||
+        std::chrono::steady_clock::now() - lastActivity < std::chrono::microseconds(spinBudget))
+    {
+      cpuRelax();
+      continue;
+    }
+
+    // spin budget exhausted, sleep until the next event
+    sleeps++;
+    handlers += ioService.run_one();
+    lastActivity = std::chrono::steady_clock::now();
+  }
+}
+
+void BusyPollLoop::printReport(std::ostream& os) const
+{
+  os << "Event Loop: busy-poll (spin " << spinBudget << "usec), "
+     << handlers << " handlers, "
+     << polls << " polls, "
+     << emptyPolls << " empty polls, "
+     << sleeps << " sleeps" << std::endl;
+}
+
+} // namespace ndn
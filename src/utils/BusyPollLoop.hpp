@@ -0,0 +1,52 @@
+#ifndef NDN_APPS_BUSYPOLLLOOP_HPP
+#define NDN_APPS_BUSYPOLLLOOP_HPP
+
+#include "boost/asio/io_service.hpp"
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ndn
+{
+
+/** Parses a CPU list like "2,4-6", throws std::invalid_argument on malformed lists */
+std::vector<int> parseCpuList(const std::string& list);
+
+/** Pins the calling thread to cpu, throws std::runtime_error on failure */
+void pinCurrentThread(int cpu);
+
+/** Pins thread to cpu, throws std::runtime_error on failure */
+void pinThread(std::thread& thread, int cpu);
+
+/**
+ * Runs an io_service by spinning on poll() instead of sleeping in epoll.
+ *
+ * After the last handler ran the loop keeps polling for spinBudget microseconds, then blocks
+ * in run_one() until the next event. A budget of -1 never blocks. Like io_service::run() the
+ * loop returns once the io_service is stopped or runs out of work.
+ */
+class BusyPollLoop
+{
+public:
+  BusyPollLoop(boost::asio::io_service& ioService, int64_t spinBudget);
+
+  void run();
+
+  void printReport(std::ostream& os) const;
+
+private:
+  boost::asio::io_service& ioService;
+  int64_t spinBudget;
+
+  uint64_t handlers;
+  uint64_t polls;
+  uint64_t emptyPolls;
+  uint64_t sleeps;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_BUSYPOLLLOOP_HPP
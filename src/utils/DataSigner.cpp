@@ -0,0 +1,293 @@
+#include "DataSigner.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/encoding/encoding-buffer.hpp>
+#include <ndn-cxx/security/cryptopp.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+
+#include <stdexcept>
+
+namespace ndn
+{
+
+namespace
+{
+  const size_t DIGEST_SIZE = CryptoPP::SHA256::DIGESTSIZE;
+  const size_t HMAC_KEY_SIZE = 32;
+
+  // domain separation of the Merkle tree, a leaf can never be taken for an inner node
+  const uint8_t LEAF_PREFIX = 0x00;
+  const uint8_t NODE_PREFIX = 0x01;
+
+  typedef std::vector<uint8_t> Digest;
+
+  Digest sha256(const uint8_t* buffer, size_t length)
+  {
+    Digest digest(DIGEST_SIZE);
+    CryptoPP::SHA256().CalculateDigest(&digest[0], buffer, length);
+    return digest;
+  }
+
+  Digest hashLeaf(const uint8_t* buffer, size_t length)
+  {
+    Digest digest(DIGEST_SIZE);
+    CryptoPP::SHA256 hash;
+    hash.Update(&LEAF_PREFIX, 1);
+    hash.Update(buffer, length);
+    hash.Final(&digest[0]);
+    return digest;
+  }
+
+  Digest hashNode(const Digest& left, const Digest& right)
+  {
+    Digest digest(DIGEST_SIZE);
+    CryptoPP::SHA256 hash;
+    hash.Update(&NODE_PREFIX, 1);
+    hash.Update(&left[0], left.size());
+    hash.Update(&right[0], right.size());
+    hash.Final(&digest[0]);
+    return digest;
+  }
+
+  Name getIdentityName(DataSigner::Algorithm algorithm)
+  {
+    return Name("/localhost/ndn-apps/producer").append(DataSigner::getAlgorithmName(algorithm));
+  }
+
+} // namespace
+
+DataSigner::Algorithm DataSigner::parseAlgorithm(const std::string& name)
+{
+  if (name == "default")
+    return DEFAULT;
+  if (name == "rsa")
+    return RSA;
+  if (name == "ecdsa")
+    return ECDSA;
+  if (name == "hmac")
+    return HMAC;
+  if (name == "sha256")
+    return DIGEST_SHA256;
+  throw std::invalid_argument("Unknown signing algorithm \"" + name + "\"");
+}
+
+std::string DataSigner::getAlgorithmName(Algorithm algorithm)
+{
+  switch (algorithm)
+  {
+    case RSA: return "rsa";
+    case ECDSA: return "ecdsa";
+    case HMAC: return "hmac";
+    case DIGEST_SHA256: return "sha256";
+    case DEFAULT:
+    default: return "default";
+  }
+}
+
+DataSigner::DataSigner(KeyChain& keyChain, Algorithm algorithm)
+  : keyChain(keyChain)
+  , algorithm(algorithm)
+  , packets(0)
+  , signatures(0)
+  , elapsed(0)
+{
+  switch (algorithm)
+  {
+    case RSA:
+    case ECDSA:
+    {
+      Name identity = getIdentityName(algorithm);
+      if (!keyChain.doesIdentityExist(identity))
+      {
+        if (algorithm == RSA)
+          keyChain.createIdentity(identity, RsaKeyParams());
+        else
+          keyChain.createIdentity(identity, EcdsaKeyParams());
+      }
+      signingInfo = security::signingByIdentity(identity);
+      keyLocatorName = keyChain.getDefaultCertificateNameForIdentity(identity);
+      break;
+    }
+    case HMAC:
+    {
+      // a per-run shared secret, enough to benchmark the cost of HMAC signing
+      hmacKey.resize(HMAC_KEY_SIZE);
+      CryptoPP::AutoSeededRandomPool rng;
+      rng.GenerateBlock(&hmacKey[0], hmacKey.size());
+      keyLocatorName = Name(getIdentityName(algorithm)).append("KEY");
+      break;
+    }
+    case DIGEST_SHA256:
+      signingInfo = security::signingWithSha256();
+      break;
+    case DEFAULT:
+    default:
+      // the default SigningInfo lets the KeyChain pick (or create) the default identity on first use
+      break;
+  }
+}
+
+void DataSigner::sign(Data& data)
+{
+  time::steady_clock::TimePoint start = time::steady_clock::now();
+
+  if (algorithm == HMAC)
+  {
+    data.setSignature(Signature(makeSignatureInfo(SIGNATURE_HMAC_WITH_SHA256)));
+
+    EncodingBuffer encoder;
+    data.wireEncode(encoder, true);
+    data.wireEncode(encoder, signBuffer(encoder.buf(), encoder.size()));
+  }
+  else
+    keyChain.sign(data, signingInfo);
+
+  signatures++;
+  account(start, 1);
+}
+
+void DataSigner::signBatch(const std::vector<shared_ptr<Data> >& batch)
+{
+  if (batch.empty())
+    return;
+
+  time::steady_clock::TimePoint start = time::steady_clock::now();
+
+  // all packets share the same SignatureInfo, so it is part of every leaf
+  Signature signature(makeSignatureInfo(SIGNATURE_MERKLE_BATCH));
+  std::vector<shared_ptr<EncodingBuffer> > encoders;
+  std::vector<std::vector<Digest> > levels(1);
+  for (std::vector<shared_ptr<Data> >::const_iterator it = batch.begin(); it != batch.end(); ++it)
+  {
+    (*it)->setSignature(signature);
+    shared_ptr<EncodingBuffer> encoder = make_shared<EncodingBuffer>();
+    (*it)->wireEncode(*encoder, true);
+    levels[0].push_back(hashLeaf(encoder->buf(), encoder->size()));
+    encoders.push_back(encoder);
+  }
+
+  // an unpaired node is promoted as is, pairing it with itself would give other batches the same root
+  while (levels.back().size() > 1)
+  {
+    const std::vector<Digest>& level = levels.back();
+    std::vector<Digest> parent;
+    for (size_t i = 0; i < level.size(); i += 2)
+    {
+      if (i + 1 < level.size())
+        parent.push_back(hashNode(level[i], level[i + 1]));
+      else
+        parent.push_back(level[i]);
+    }
+    levels.push_back(parent);
+  }
+
+  const Digest& root = levels.back()[0];
+  Block rootSignature = signBuffer(&root[0], root.size());
+
+  for (size_t leaf = 0; leaf < batch.size(); ++leaf)
+  {
+    Block value(tlv::SignatureValue);
+    value.push_back(makeNonNegativeIntegerBlock(MERKLE_LEAF_INDEX, leaf));
+    value.push_back(makeNonNegativeIntegerBlock(MERKLE_LEAF_COUNT, batch.size()));
+
+    // levels where the node was promoted have no sibling, the leaf count tells the verifier which
+    size_t index = leaf;
+    for (size_t depth = 0; depth + 1 < levels.size(); ++depth)
+    {
+      const std::vector<Digest>& level = levels[depth];
+      size_t sibling = index ^ 1;
+      if (sibling < level.size())
+        value.push_back(dataBlock(MERKLE_PROOF_DIGEST, &level[sibling][0], DIGEST_SIZE));
+      index >>= 1;
+    }
+
+    value.push_back(rootSignature);
+    value.encode();
+    batch[leaf]->wireEncode(*encoders[leaf], value);
+  }
+
+  signatures++;
+  account(start, batch.size());
+}
+
+Block DataSigner::signBuffer(const uint8_t* buffer, size_t length)
+{
+  switch (algorithm)
+  {
+    case HMAC:
+    {
+      uint8_t mac[DIGEST_SIZE];
+      CryptoPP::HMAC<CryptoPP::SHA256> hmac(&hmacKey[0], hmacKey.size());
+      hmac.CalculateDigest(mac, buffer, length);
+      return dataBlock(tlv::SignatureValue, mac, sizeof(mac));
+    }
+    case DIGEST_SHA256:
+    {
+      Digest digest = sha256(buffer, length);
+      return dataBlock(tlv::SignatureValue, &digest[0], digest.size());
+    }
+    default:
+      return keyChain.sign(buffer, length, signingInfo);
+  }
+}
+
+SignatureInfo DataSigner::makeSignatureInfo(uint32_t type)
+{
+  // only batch signing needs the default certificate name, resolve it lazily
+  if (algorithm == DEFAULT && keyLocatorName.empty())
+  {
+    try
+    {
+      keyLocatorName = keyChain.getDefaultCertificateName();
+    }
+    catch (const std::exception&)
+    {
+      // no default identity yet, create one as the KeyChain does for default signing
+      Name identity = getIdentityName(algorithm);
+      keyLocatorName = keyChain.createIdentity(identity);
+      keyChain.setDefaultIdentity(identity);
+    }
+  }
+
+  if (keyLocatorName.empty())
+    return SignatureInfo(static_cast<tlv::SignatureTypeValue>(type));
+  return SignatureInfo(static_cast<tlv::SignatureTypeValue>(type), KeyLocator(keyLocatorName));
+}
+
+void DataSigner::account(const time::steady_clock::TimePoint& start, size_t count)
+{
+  elapsed += time::steady_clock::now() - start;
+  packets += count;
+}
+
+DataSigner::Algorithm DataSigner::getAlgorithm() const
+{
+  return algorithm;
+}
+
+uint64_t DataSigner::getPackets() const
+{
+  return packets;
+}
+
+uint64_t DataSigner::getSignatures() const
+{
+  return signatures;
+}
+
+double DataSigner::getSeconds() const
+{
+  return time::duration_cast<time::microseconds>(elapsed).count() / 1000000.0;
+}
+
+void DataSigner::printReport(std::ostream& os) const
+{
+  double seconds = getSeconds();
+  os << "Signing (" << getAlgorithmName(algorithm) << "): "
+     << packets << " packets, "
+     << signatures << " signatures, "
+     << seconds * 1000 << "msec, "
+     << (seconds > 0 ? packets / seconds : 0) << " packets/s" << std::endl;
+}
+
+} // namespace ndn
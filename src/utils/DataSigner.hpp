@@ -0,0 +1,84 @@
+#ifndef NDN_APPS_DATASIGNER_HPP
+#define NDN_APPS_DATASIGNER_HPP
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ndn
+{
+
+/**
+ * Signs Data packets with a selectable algorithm, either one signature per packet or
+ * one signature per batch.
+ *
+ * A batch is signed Merkle-style: the leaves are the SHA-256 digests of the packets'
+ * unsigned portions, only the root is signed with the selected algorithm. As in RFC 6962
+ * leaves are hashed with a 0x00 prefix, inner nodes with a 0x01 prefix, and an unpaired
+ * node is promoted to the next level. Each packet carries SignatureType
+ * SIGNATURE_MERKLE_BATCH and a SignatureValue holding its leaf index, the leaf count, the
+ * existing sibling digests from leaf to root and the root signature.
+ */
+class DataSigner : noncopyable
+{
+public:
+  enum Algorithm
+  {
+    DEFAULT, // default identity of the KeyChain
+    RSA,
+    ECDSA,
+    HMAC,
+    DIGEST_SHA256
+  };
+
+  // SignatureType values not known to ndn-cxx
+  static const uint32_t SIGNATURE_HMAC_WITH_SHA256 = 4;
+  static const uint32_t SIGNATURE_MERKLE_BATCH = 200;
+
+  // TLV types inside the SignatureValue of batch signed packets
+  static const uint32_t MERKLE_LEAF_INDEX = 201;
+  static const uint32_t MERKLE_PROOF_DIGEST = 202;
+  static const uint32_t MERKLE_LEAF_COUNT = 203;
+
+  /** Throws std::invalid_argument for unknown names */
+  static Algorithm parseAlgorithm(const std::string& name);
+  static std::string getAlgorithmName(Algorithm algorithm);
+
+  /** RSA and ECDSA keys are created under a dedicated identity on first use */
+  DataSigner(KeyChain& keyChain, Algorithm algorithm);
+
+  void sign(Data& data);
+  void signBatch(const std::vector<shared_ptr<Data> >& batch);
+
+  Algorithm getAlgorithm() const;
+  uint64_t getPackets() const;
+  uint64_t getSignatures() const;
+  double getSeconds() const;
+
+  /** Prints packets, signatures and signing throughput */
+  void printReport(std::ostream& os) const;
+
+private:
+  /** Signs an arbitrary buffer, returns the SignatureValue block */
+  Block signBuffer(const uint8_t* buffer, size_t length);
+  SignatureInfo makeSignatureInfo(uint32_t type);
+  void account(const time::steady_clock::TimePoint& start, size_t packets);
+
+private:
+  KeyChain& keyChain;
+  Algorithm algorithm;
+  security::SigningInfo signingInfo;
+  Name keyLocatorName;
+  std::vector<uint8_t> hmacKey;
+
+  uint64_t packets;
+  uint64_t signatures;
+  time::nanoseconds elapsed;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_DATASIGNER_HPP
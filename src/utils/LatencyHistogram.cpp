@@ -0,0 +1,144 @@
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  const unsigned SUB_BUCKET_BITS = 6;
+  const uint64_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+  const uint64_t LINEAR_LIMIT = 2 * SUB_BUCKET_COUNT; // values below are stored exactly
+  const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+
+  inline unsigned log2floor(uint64_t value)
+  {
+    unsigned result = 0;
+    while (value >>= 1)
+      ++result;
+    return result;
+  }
+
+} // namespace
+
+namespace ndn
+{
+
+LatencyHistogram::LatencyHistogram()
+  : buckets(BUCKET_COUNT, 0)
+{
+  reset();
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+  if (value < LINEAR_LIMIT)
+    return static_cast<size_t>(value);
+
+  // the top SUB_BUCKET_BITS + 1 bits select the bucket
+  unsigned shift = log2floor(value) - SUB_BUCKET_BITS;
+  return static_cast<size_t>(shift * SUB_BUCKET_COUNT + (value >> shift));
+}
+
+uint64_t LatencyHistogram::bucketValue(size_t index)
+{
+  if (index < LINEAR_LIMIT)
+    return index;
+
+  // report the middle of the bucket
+  unsigned shift = static_cast<unsigned>(index / SUB_BUCKET_COUNT) - 1;
+  uint64_t lower = (index - shift * SUB_BUCKET_COUNT) << shift;
+  return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::add(uint64_t value)
+{
+  buckets[bucketIndex(value)]++;
+  count++;
+  if (value < min)
+    min = value;
+  if (value > max)
+    max = value;
+  sum += value;
+  sumOfSquares += static_cast<double>(value) * value;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+  for (size_t i = 0; i < buckets.size(); ++i)
+    buckets[i] += other.buckets[i];
+  count += other.count;
+  if (other.min < min)
+    min = other.min;
+  if (other.max > max)
+    max = other.max;
+  sum += other.sum;
+  sumOfSquares += other.sumOfSquares;
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(buckets.begin(), buckets.end(), 0);
+  count = 0;
+  min = std::numeric_limits<uint64_t>::max();
+  max = 0;
+  sum = 0;
+  sumOfSquares = 0;
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+  return count;
+}
+
+uint64_t LatencyHistogram::getMin() const
+{
+  return count > 0 ? min : 0;
+}
+
+uint64_t LatencyHistogram::getMax() const
+{
+  return max;
+}
+
+double LatencyHistogram::getMean() const
+{
+  return count > 0 ? sum / count : 0;
+}
+
+double LatencyHistogram::getStddev() const
+{
+  if (count < 2)
+    return 0;
+
+  double mean = sum / count;
+  double variance = sumOfSquares / count - mean * mean;
+  return variance > 0 ? std::sqrt(variance) : 0;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percent) const
+{
+  if (count == 0)
+    return 0;
+
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percent / 100.0 * count));
+  if (rank == 0)
+    rank = 1;
+  if (rank >= count)
+    return max;
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i)
+  {
+    seen += buckets[i];
+    if (seen >= rank)
+    {
+      // never report beyond the observed range
+      uint64_t value = bucketValue(i);
+      return value < min ? min : (value > max ? max : value);
+    }
+  }
+  return max;
+}
+
+} // namespace ndn
@@ -0,0 +1,51 @@
+#ifndef NDN_APPS_LATENCYHISTOGRAM_HPP
+#define NDN_APPS_LATENCYHISTOGRAM_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace ndn
+{
+
+/**
+ * Log-linear histogram of latency samples in microseconds.
+ *
+ * Memory is fixed regardless of the number of samples. Values below 128 are exact; larger
+ * values fall into one of 64 sub-buckets per power of two, so percentiles are within ~1.6%.
+ * Mean and standard deviation are computed from the exact samples.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+
+  void add(uint64_t value);
+  void merge(const LatencyHistogram& other);
+  void reset();
+
+  uint64_t getCount() const;
+  uint64_t getMin() const;
+  uint64_t getMax() const;
+  double getMean() const;
+  double getStddev() const;
+
+  /** Returns the value below which the given percentage (0-100) of the samples fall */
+  uint64_t getPercentile(double percent) const;
+
+private:
+  static size_t bucketIndex(uint64_t value);
+  static uint64_t bucketValue(size_t index);
+
+private:
+  std::vector<uint64_t> buckets;
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  double sum;
+  double sumOfSquares;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_LATENCYHISTOGRAM_HPP
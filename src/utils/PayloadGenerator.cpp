@@ -0,0 +1,161 @@
+#include "PayloadGenerator.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+  const size_t BLOCK_SIZE = 16; // two 64 bit lanes per generator step
+
+  uint64_t splitmix64(uint64_t& state)
+  {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  struct State
+  {
+    uint64_t s0[2];
+    uint64_t s1[2];
+
+    explicit State(uint64_t seed)
+    {
+      s0[0] = splitmix64(seed);
+      s0[1] = splitmix64(seed);
+      s1[0] = splitmix64(seed);
+      s1[1] = splitmix64(seed);
+    }
+  };
+
+  /** Portable generator step, stores the little endian output of both lanes into block */
+  inline void step(State& state, uint8_t* block)
+  {
+    for (int lane = 0; lane < 2; ++lane)
+    {
+      uint64_t x = state.s0[lane];
+      uint64_t y = state.s1[lane];
+      state.s0[lane] = y;
+      x ^= x << 23;
+      state.s1[lane] = x ^ y ^ (x >> 17) ^ (y >> 26);
+
+      uint64_t out = state.s1[lane] + y;
+      for (int i = 0; i < 8; ++i)
+        block[lane * 8 + i] = static_cast<uint8_t>(out >> (8 * i));
+    }
+  }
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__))
+  // SSE2 lanes are little endian, so the vector output matches step() byte for byte.
+  struct VectorState
+  {
+    __m128i s0;
+    __m128i s1;
+
+    explicit VectorState(const State& state)
+    {
+      s0 = _mm_set_epi64x(static_cast<long long>(state.s0[1]), static_cast<long long>(state.s0[0]));
+      s1 = _mm_set_epi64x(static_cast<long long>(state.s1[1]), static_cast<long long>(state.s1[0]));
+    }
+
+    void store(State& state) const
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(state.s0), s0);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(state.s1), s1);
+    }
+  };
+
+  inline __m128i vectorStep(VectorState& state)
+  {
+    __m128i x = state.s0;
+    __m128i y = state.s1;
+    state.s0 = y;
+    x = _mm_xor_si128(x, _mm_slli_epi64(x, 23));
+    state.s1 = _mm_xor_si128(_mm_xor_si128(x, y),
+                             _mm_xor_si128(_mm_srli_epi64(x, 17), _mm_srli_epi64(y, 26)));
+    return _mm_add_epi64(state.s1, y);
+  }
+#define NDN_APPS_PAYLOAD_SSE2 1
+#endif
+
+} // namespace
+
+namespace ndn
+{
+
+uint64_t PayloadGenerator::hash(const uint8_t* buffer, size_t length)
+{
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for (size_t i = 0; i < length; ++i)
+  {
+    h ^= buffer[i];
+    h *= 0x100000001B3ULL;
+  }
+  return h;
+}
+
+void PayloadGenerator::fill(uint64_t seed, uint8_t* buffer, size_t length)
+{
+  State state(seed);
+  size_t offset = 0;
+
+#ifdef NDN_APPS_PAYLOAD_SSE2
+  VectorState vstate(state);
+  for (; offset + BLOCK_SIZE <= length; offset += BLOCK_SIZE)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + offset), vectorStep(vstate));
+  vstate.store(state);
+#else
+  for (; offset + BLOCK_SIZE <= length; offset += BLOCK_SIZE)
+    step(state, buffer + offset);
+#endif
+
+  if (offset < length)
+  {
+    uint8_t block[BLOCK_SIZE];
+    step(state, block);
+    std::memcpy(buffer + offset, block, length - offset);
+  }
+}
+
+bool PayloadGenerator::verify(uint64_t seed, const uint8_t* buffer, size_t length)
+{
+  State state(seed);
+  size_t offset = 0;
+
+#ifdef NDN_APPS_PAYLOAD_SSE2
+  // accumulate differences instead of branching per block, the check stays branch free
+  VectorState vstate(state);
+  __m128i diff = _mm_setzero_si128();
+  for (; offset + BLOCK_SIZE <= length; offset += BLOCK_SIZE)
+  {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + offset));
+    diff = _mm_or_si128(diff, _mm_xor_si128(data, vectorStep(vstate)));
+  }
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF)
+    return false;
+  vstate.store(state);
+#else
+  uint8_t block[BLOCK_SIZE];
+  for (; offset + BLOCK_SIZE <= length; offset += BLOCK_SIZE)
+  {
+    step(state, block);
+    if (std::memcmp(buffer + offset, block, BLOCK_SIZE) != 0)
+      return false;
+  }
+#endif
+
+  if (offset < length)
+  {
+    uint8_t tail[BLOCK_SIZE];
+    step(state, tail);
+    if (std::memcmp(buffer + offset, tail, length - offset) != 0)
+      return false;
+  }
+  return true;
+}
+
+} // namespace ndn
@@ -0,0 +1,31 @@
+#ifndef NDN_APPS_PAYLOADGENERATOR_HPP
+#define NDN_APPS_PAYLOADGENERATOR_HPP
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace ndn
+{
+
+/**
+ * Generates and checks deterministic payloads derived from a 64 bit seed.
+ *
+ * The byte stream is produced by two interleaved xorshift128+ generators, so the SSE2
+ * path and the portable fallback emit exactly the same bytes on every host.
+ */
+class PayloadGenerator
+{
+public:
+  /** FNV-1a hash, used to derive a seed from the wire encoding of a name */
+  static uint64_t hash(const uint8_t* buffer, size_t length);
+
+  /** Fills buffer with length bytes of the stream selected by seed */
+  static void fill(uint64_t seed, uint8_t* buffer, size_t length);
+
+  /** Returns true if buffer holds exactly the first length bytes of the stream selected by seed */
+  static bool verify(uint64_t seed, const uint8_t* buffer, size_t length);
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_PAYLOADGENERATOR_HPP
@@ -0,0 +1,237 @@
+#include "PerfCounters.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ndn
+{
+
+namespace
+{
+  const char* COUNTER_NAMES[PerfCounters::COUNTER_COUNT] = {
+    "cycles", "instructions", "cache-misses", "branch-misses"
+  };
+
+  const int CALIBRATION_SAMPLES = 101;
+
+#ifdef __linux__
+  const uint64_t COUNTER_CONFIGS[PerfCounters::COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  int openCounter(uint64_t config, int groupFd, bool excludeKernel)
+  {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = groupFd == -1 ? 1 : 0;
+    attr.exclude_kernel = excludeKernel ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // calling thread, any CPU
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+  }
+#endif
+
+} // namespace
+
+PerfCounters::PerfCounters()
+  : members(0)
+{
+  for (int i = 0; i < COUNTER_COUNT; ++i)
+  {
+    fds[i] = -1;
+    groupIndex[i] = -1;
+    overhead[i] = 0;
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for (int i = COUNTER_COUNT - 1; i >= 0; --i)
+  {
+    if (fds[i] != -1)
+      close(fds[i]);
+  }
+#endif
+}
+
+bool PerfCounters::open()
+{
+#ifdef __linux__
+  // with perf_event_paranoid >= 2 only user space may be counted, which still covers the apps' own code
+  bool excludeKernel = false;
+  fds[CYCLES] = openCounter(COUNTER_CONFIGS[CYCLES], -1, excludeKernel);
+  if (fds[CYCLES] == -1 && (errno == EACCES || errno == EPERM))
+  {
+    excludeKernel = true;
+    fds[CYCLES] = openCounter(COUNTER_CONFIGS[CYCLES], -1, excludeKernel);
+  }
+  if (fds[CYCLES] == -1)
+  {
+    error = std::string("perf_event_open failed: ") + strerror(errno);
+    return false;
+  }
+  groupIndex[CYCLES] = members++;
+
+  for (int i = CYCLES + 1; i < COUNTER_COUNT; ++i)
+  {
+    fds[i] = openCounter(COUNTER_CONFIGS[i], fds[CYCLES], excludeKernel);
+    if (fds[i] != -1)
+      groupIndex[i] = members++;
+  }
+
+  if (excludeKernel)
+    error = "counting user space only";
+
+  ioctl(fds[CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds[CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  calibrate();
+  return true;
+#else
+  error = "performance counters are only supported on Linux";
+  return false;
+#endif
+}
+
+bool PerfCounters::isAvailable() const
+{
+  return fds[CYCLES] != -1;
+}
+
+const std::string& PerfCounters::getError() const
+{
+  return error;
+}
+
+size_t PerfCounters::addStage(const std::string& name)
+{
+  Stage stage;
+  stage.name = name;
+  stage.samples = 0;
+  for (int i = 0; i < COUNTER_COUNT; ++i)
+    stage.totals[i] = 0;
+  stages.push_back(stage);
+  return stages.size() - 1;
+}
+
+bool PerfCounters::read(Sample& sample)
+{
+#ifdef __linux__
+  // layout of a PERF_FORMAT_GROUP read: nr, time_enabled, time_running, values[nr]
+  uint64_t buffer[3 + COUNTER_COUNT];
+  ssize_t expected = (3 + members) * sizeof(uint64_t);
+  if (::read(fds[CYCLES], buffer, sizeof(buffer)) < expected)
+    return false;
+
+  sample.enabled = buffer[1];
+  sample.running = buffer[2];
+  for (int i = 0; i < COUNTER_COUNT; ++i)
+    sample.values[i] = groupIndex[i] >= 0 ? buffer[3 + groupIndex[i]] : 0;
+  return true;
+#else
+  (void) sample;
+  return false;
+#endif
+}
+
+void PerfCounters::calibrate()
+{
+  // the median of empty samples, robust against the odd interrupt or migration
+  std::vector<double> deltas[COUNTER_COUNT];
+  for (int n = 0; n < CALIBRATION_SAMPLES; ++n)
+  {
+    Sample start, end;
+    if (!read(start) || !read(end))
+      return;
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+      deltas[i].push_back((double) (end.values[i] - start.values[i]));
+  }
+
+  for (int i = 0; i < COUNTER_COUNT; ++i)
+  {
+    std::nth_element(deltas[i].begin(), deltas[i].begin() + deltas[i].size() / 2, deltas[i].end());
+    overhead[i] = deltas[i][deltas[i].size() / 2];
+  }
+}
+
+void PerfCounters::start(Sample& sample)
+{
+  if (!read(sample))
+    sample.enabled = sample.running = 0;
+}
+
+void PerfCounters::stop(size_t stage, const Sample& start, size_t packets)
+{
+  Sample end;
+  if (start.enabled == 0 || !read(end))
+    return;
+
+  // scale up if the group was multiplexed with other events during the stage
+  uint64_t running = end.running - start.running;
+  double scale = running > 0 ? (double) (end.enabled - start.enabled) / (double) running : 1.0;
+
+  // not clamped per sample, that would bias stages shorter than the noise of the overhead
+  Stage& s = stages[stage];
+  s.samples += packets;
+  for (int i = 0; i < COUNTER_COUNT; ++i)
+    s.totals[i] += (end.values[i] - start.values[i]) * scale - overhead[i];
+}
+
+void PerfCounters::printReport(std::ostream& os) const
+{
+  if (!isAvailable())
+  {
+    os << "Performance Counters: unavailable (" << error << ")" << std::endl;
+    return;
+  }
+
+  os << "Performance Counters per packet";
+  if (!error.empty())
+    os << " (" << error << ")";
+  os << ", " << overhead[CYCLES] << " cycles of read overhead subtracted per sample:" << std::endl;
+
+  os << std::left << std::setw(12) << "stage"
+     << std::right << std::setw(10) << "packets";
+  for (int i = 0; i < COUNTER_COUNT; ++i)
+    os << std::setw(15) << COUNTER_NAMES[i];
+  os << std::setw(8) << "IPC" << std::endl;
+
+  for (std::vector<Stage>::const_iterator it = stages.begin(); it != stages.end(); ++it)
+  {
+    os << std::left << std::setw(12) << it->name
+       << std::right << std::setw(10) << it->samples
+       << std::fixed << std::setprecision(1);
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+      if (groupIndex[i] < 0 || it->samples == 0)
+        os << std::setw(15) << "n/a";
+      else
+        os << std::setw(15) << std::max(0.0, it->totals[i] / it->samples);
+    }
+
+    if (groupIndex[INSTRUCTIONS] >= 0 && it->totals[CYCLES] > 0 && it->totals[INSTRUCTIONS] > 0)
+      os << std::setw(8) << std::setprecision(2) << it->totals[INSTRUCTIONS] / it->totals[CYCLES];
+    else
+      os << std::setw(8) << "n/a";
+    os << std::resetiosflags(std::ios::floatfield) << std::setprecision(6) << std::endl;
+  }
+}
+
+} // namespace ndn
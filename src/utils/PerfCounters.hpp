@@ -0,0 +1,110 @@
+#ifndef NDN_APPS_PERFCOUNTERS_HPP
+#define NDN_APPS_PERFCOUNTERS_HPP
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ndn
+{
+
+/**
+ * Hardware performance counters of the calling thread, accounted per hot-path stage.
+ *
+ * Uses one perf_event_open group (cycles, instructions, cache misses, branch misses).
+ * Counters the host does not provide are reported as n/a; if not even cycles can be opened
+ * (no PMU, perf_event_paranoid, non-Linux host) all stages become no-ops.
+ * Each sample costs one read() system call at start and stop of a stage. open() measures
+ * the counts of an empty sample and every sample is reduced by them, so the syscall exit and
+ * entry around a stage do not inflate short stages.
+ */
+class PerfCounters
+{
+public:
+  enum Counter
+  {
+    CYCLES,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    COUNTER_COUNT
+  };
+
+  struct Sample
+  {
+    uint64_t values[COUNTER_COUNT];
+    uint64_t enabled;
+    uint64_t running;
+  };
+
+  PerfCounters();
+  ~PerfCounters();
+
+  /** Opens the counters for the calling thread, returns false if they are unavailable */
+  bool open();
+
+  bool isAvailable() const;
+  const std::string& getError() const;
+
+  /** Registers a stage, returns its index for start()/stop() */
+  size_t addStage(const std::string& name);
+
+  void start(Sample& sample);
+  void stop(size_t stage, const Sample& start, size_t packets = 1);
+
+  /** Prints per-packet cycles, instructions, IPC, cache and branch misses of each stage */
+  void printReport(std::ostream& os) const;
+
+private:
+  bool read(Sample& sample);
+  void calibrate();
+
+  PerfCounters(const PerfCounters&);
+  PerfCounters& operator=(const PerfCounters&);
+
+private:
+  struct Stage
+  {
+    std::string name;
+    uint64_t samples;
+    double totals[COUNTER_COUNT];
+  };
+
+  int fds[COUNTER_COUNT];
+  int groupIndex[COUNTER_COUNT]; // position in the group read, -1 if unavailable
+  int members;
+  double overhead[COUNTER_COUNT]; // counts of an empty sample
+  std::string error;
+  std::vector<Stage> stages;
+};
+
+/** Accounts the enclosing scope to a stage, does nothing if counters is NULL or unavailable */
+class PerfScope
+{
+public:
+  PerfScope(PerfCounters* counters, size_t stage, size_t packets = 1)
+    : counters(counters != NULL && counters->isAvailable() ? counters : NULL)
+    , stage(stage)
+    , packets(packets)
+  {
+    if (this->counters)
+      this->counters->start(sample);
+  }
+
+  ~PerfScope()
+  {
+    if (counters)
+      counters->stop(stage, sample, packets);
+  }
+
+private:
+  PerfCounters* counters;
+  size_t stage;
+  size_t packets;
+  PerfCounters::Sample sample;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_PERFCOUNTERS_HPP
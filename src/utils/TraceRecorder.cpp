@@ -0,0 +1,207 @@
+#include "TraceRecorder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+  const size_t CACHE_LINE_SIZE = 64;
+  const size_t FILE_BUFFER_SIZE = 1 << 20;
+
+  std::atomic<uint64_t> nextInstance(1);
+
+  // per-thread ring cache, tagged with the recorder instance that owns the ring
+  thread_local uint64_t cachedInstance = 0;
+  thread_local void* cachedRing = NULL;
+
+  inline uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  size_t roundUpToPowerOfTwo(size_t value)
+  {
+    size_t result = 1;
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+} // namespace
+
+namespace ndn
+{
+
+class TraceRecorder::Ring
+{
+public:
+  Ring(size_t capacity, uint16_t thread)
+    : events(capacity)
+    , mask(capacity - 1)
+    , thread(thread)
+    , head(0)
+    , dropped(0)
+    , tail(0)
+  {
+  }
+
+  /** Called by the owning thread only */
+  void push(uint16_t type, uint64_t id, uint32_t size)
+  {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == events.size())
+    {
+      dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return;
+    }
+
+    TraceEvent& event = events[h & mask];
+    event.timestamp = now();
+    event.id = id;
+    event.size = size;
+    event.type = type;
+    event.thread = thread;
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  /** Called by the writer thread only, returns the number of events written */
+  size_t drainTo(FILE* file)
+  {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    size_t count = h - t;
+    if (count == 0)
+      return 0;
+
+    // the pending events wrap around at most once
+    size_t first = t & mask;
+    size_t firstCount = std::min(count, events.size() - first);
+    fwrite(&events[first], sizeof(TraceEvent), firstCount, file);
+    if (firstCount < count)
+      fwrite(&events[0], sizeof(TraceEvent), count - firstCount, file);
+
+    tail.store(h, std::memory_order_release);
+    return count;
+  }
+
+  uint64_t getPushed() const
+  {
+    return head.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getDropped() const
+  {
+    return dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::vector<TraceEvent> events;
+  const size_t mask;
+  const uint16_t thread;
+
+  // keep the producer and consumer indices on separate cache lines
+  char padding0[CACHE_LINE_SIZE];
+  std::atomic<size_t> head;
+  std::atomic<uint64_t> dropped;
+  char padding1[CACHE_LINE_SIZE];
+  std::atomic<size_t> tail;
+};
+
+TraceRecorder::TraceRecorder(const std::string& fileName, size_t ringCapacity)
+  : file(NULL)
+  , ringCapacity(roundUpToPowerOfTwo(ringCapacity))
+  , instance(nextInstance++)
+  , running(true)
+  , written(0)
+{
+  file = fopen(fileName.c_str(), "wb");
+  if (file == NULL)
+    throw std::runtime_error("Can not open trace file " + fileName + ": " + strerror(errno));
+  setvbuf(file, NULL, _IOFBF, FILE_BUFFER_SIZE);
+
+  TraceHeader header;
+  std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_VERSION;
+  header.recordSize = sizeof(TraceEvent);
+  fwrite(&header, sizeof(header), 1, file);
+
+  writer = std::thread(&TraceRecorder::writerLoop, this);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+  running = false;
+  writer.join();
+  drain();
+  fclose(file);
+
+  for (std::vector<Ring*>::iterator it = rings.begin(); it != rings.end(); ++it)
+    delete *it;
+}
+
+void TraceRecorder::record(uint16_t type, uint64_t id, uint32_t size)
+{
+  threadRing()->push(type, id, size);
+}
+
+uint64_t TraceRecorder::getRecorded() const
+{
+  return written;
+}
+
+uint64_t TraceRecorder::getDropped() const
+{
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  uint64_t dropped = 0;
+  for (std::vector<Ring*>::const_iterator it = rings.begin(); it != rings.end(); ++it)
+    dropped += (*it)->getDropped();
+  return dropped;
+}
+
+TraceRecorder::Ring* TraceRecorder::threadRing()
+{
+  if (cachedInstance == instance)
+    return static_cast<Ring*>(cachedRing);
+
+  // first event of this thread, the only path that takes the lock
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  Ring* ring = new Ring(ringCapacity, static_cast<uint16_t>(rings.size()));
+  rings.push_back(ring);
+
+  cachedInstance = instance;
+  cachedRing = ring;
+  return ring;
+}
+
+size_t TraceRecorder::drain()
+{
+  std::vector<Ring*> current;
+  {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    current = rings;
+  }
+
+  size_t count = 0;
+  for (std::vector<Ring*>::iterator it = current.begin(); it != current.end(); ++it)
+    count += (*it)->drainTo(file);
+
+  if (count > 0)
+    fflush(file);
+  written += count;
+  return count;
+}
+
+void TraceRecorder::writerLoop()
+{
+  while (running)
+  {
+    if (drain() == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+} // namespace ndn
@@ -0,0 +1,91 @@
+#ifndef NDN_APPS_TRACERECORDER_HPP
+#define NDN_APPS_TRACERECORDER_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace ndn
+{
+
+enum TraceEventType
+{
+  TRACE_INTEREST_SENT = 1,
+  TRACE_INTEREST_RECEIVED = 2,
+  TRACE_DATA_SENT = 3,
+  TRACE_DATA_RECEIVED = 4,
+  TRACE_TIMEOUT = 5,
+  TRACE_RETRANSMISSION = 6
+};
+
+/** Fixed size trace record, written to the trace file as is (host byte order) */
+struct TraceEvent
+{
+  uint64_t timestamp; // steady clock, nanoseconds
+  uint64_t id;        // name hash of the packet
+  uint32_t size;      // wire size of the packet in bytes
+  uint16_t type;      // TraceEventType
+  uint16_t thread;    // index of the recording thread
+};
+
+/** Trace file header, followed by TraceEvent records until the end of the file */
+struct TraceHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+const char TRACE_MAGIC[8] = {'N', 'D', 'N', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t TRACE_VERSION = 1;
+
+/**
+ * Records TraceEvents into per-thread single producer/single consumer rings.
+ *
+ * record() never blocks or allocates once the calling thread's ring exists; a background
+ * thread drains all rings to the trace file. Events are dropped (and counted) if a ring is full.
+ */
+class TraceRecorder
+{
+public:
+  TraceRecorder(const std::string& fileName, size_t ringCapacity = 1 << 16);
+
+  /** Stops the writer after draining all rings and closes the trace file */
+  ~TraceRecorder();
+
+  void record(uint16_t type, uint64_t id, uint32_t size);
+
+  uint64_t getRecorded() const;
+  uint64_t getDropped() const;
+
+private:
+  class Ring;
+
+  Ring* threadRing();
+  size_t drain();
+  void writerLoop();
+
+  TraceRecorder(const TraceRecorder&);
+  TraceRecorder& operator=(const TraceRecorder&);
+
+private:
+  FILE* file;
+  size_t ringCapacity;
+  uint64_t instance;
+
+  mutable std::mutex ringsMutex;
+  std::vector<Ring*> rings;
+
+  std::atomic<bool> running;
+  std::atomic<uint64_t> written;
+  std::thread writer;
+};
+
+} // namespace ndn
+
+#endif // NDN_APPS_TRACERECORDER_HPP